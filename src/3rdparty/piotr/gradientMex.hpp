@@ -31,10 +31,12 @@
 * OpenCV interface to Piotr's Computer Vision Matlab Toolbox' FHOG implementation:
 https://github.com/pdollar/toolbox/blob/612f9a0451a6abbe2a64768c9e6654692929102e/channels/private/gradientMex.cpp
 
+cvFhog computes FHOG in row major (interleaved) order, see fhogRowMajor,
+on float images or directly on uint16 depth maps; cvFhogWindow computes it
+for a window of an image whose gradients were computed once by cvFhogGradients;
+the col major (clustered) variants below remain for reference.
+
 TODO:
-* Rewrite fhog col major (clustered) calculation to row major (interleaved) calculation
-** Calculating FHOG on an implicitly transposed image is possible as well (see cvFhogT),
--- but Performance is slightly lower for an unknown reason.
 * Remove code duplication
 * Fix hackfixes properly
 
@@ -43,6 +45,7 @@ TODO:
 #ifndef _GRADIENT_MEX_HPP_
 #define _GRADIENT_MEX_HPP_
 
+#include <stdint.h>
 #include <opencv2/opencv.hpp>
 #include "feature_channels.hpp"
 #include "wrappers.hpp"
@@ -56,6 +59,59 @@ namespace piotr {
     void gradMag(float * const I, float * const M,
         float * const O, int h, int w, int d, bool full);
 
+    // grow-only aligned memory, reallocated only if more than before is requested
+    class AlignedBuffer
+    {
+    public:
+        AlignedBuffer() : m_data(0), m_size(0) {}
+        ~AlignedBuffer() { if (m_data) alFree(m_data); }
+
+        void* reserve(size_t size)
+        {
+            if (size > m_size)
+            {
+                if (m_data) alFree(m_data);
+                m_data = alMalloc(size, 64);
+                m_size = size;
+            }
+
+            return m_data;
+        }
+
+    private:
+        AlignedBuffer(const AlignedBuffer&);
+        AlignedBuffer& operator=(const AlignedBuffer&);
+
+        void* m_data;
+        size_t m_size;
+    };
+
+    // scratch memory reused by consecutive extractions,
+    // so that they do not allocate once the largest window has been seen
+    struct FhogWorkspace
+    {
+        AlignedBuffer input;   // the float patch passed to cvFhog
+        AlignedBuffer scratch; // histograms and row buffers of fhogRowMajor
+    };
+
+    // the workspace of the calling thread
+    FhogWorkspace& threadWorkspace();
+
+    template<typename T, typename P>
+    void fhogRowMajor(const P * const I, size_t step, int h, int w, int d,
+        T * const * const H, int nH, int binSize, int nOrients, float clip,
+        bool calcEnergy, AlignedBuffer& scratch);
+
+    template<typename P>
+    void fhogGradients(const P * const I, size_t step, int h, int w, int d, int y0, int y1,
+        float * const M, int * const O, size_t gradStep, int binSize, int nOrients, AlignedBuffer& scratch);
+
+    template<typename T, typename P>
+    void fhogWindowRowMajor(const P * const I, size_t step, int h, int w, int d,
+        const float * const M, const int * const O, size_t gradStep,
+        T * const * const H, int nH, int binSize, int nOrients, float clip,
+        bool calcEnergy, AlignedBuffer& scratch);
+
     template<typename PRIMITIVE_TYPE>
     void fhogToCol(const cv::Mat& img, cv::Mat& cvFeatures,
         int binSize, int colIdx, PRIMITIVE_TYPE cosFactor)
@@ -200,88 +256,100 @@ namespace piotr {
             wrFree(I);
     }
 
+    // allocate the channels of cvFhog for an image of size and point planes at the ones to compute
+    // @returns The number of channels to compute
     template<typename PRIMITIVE_TYPE, class OUT>
-    void cvFhog(const cv::Mat& img, std::shared_ptr<OUT>& cvFeatures, int binSize, int fhogChannelsToCopy = 31)
+    int fhogPlanes(const cv::Size& size, std::shared_ptr<OUT>& cvFeatures, int binSize, int fhogChannelsToCopy,
+        PRIMITIVE_TYPE** planes)
     {
-        const int orientations = 9;
-        // ensure array is continuous
-        const cv::Mat& image = (img.isContinuous() ? img : img.clone());
-        int channels = image.channels();
-        int computeChannels = 32;
-        int width = image.cols;
-        int height = image.rows;
-        int widthBin = width / binSize;
-        int heightBin = height / binSize;
+        // only copy the amount of the channels the user wants
+        // or the amount that fits into the output array
+        const size_t computeChannels = 31;
+        size_t channelsToCopy = std::min< size_t >(std::min< size_t >(fhogChannelsToCopy, computeChannels), cvFeatures->numberOfChannels());
 
-        float* const I = (float*)wrCalloc(static_cast<size_t>(width * height * channels), sizeof(float));
-        float* const H = (float*)wrCalloc(static_cast<size_t>(widthBin * heightBin * computeChannels), sizeof(float));
-        float* const M = (float*)wrCalloc(static_cast<size_t>(width * height), sizeof(float));
-        float* const O = (float*)wrCalloc(static_cast<size_t>(width * height), sizeof(float));
+        // all channels are planes of one contiguous tensor
+        cvFeatures->allocate(cv::Size(size.width / binSize, size.height / binSize), cv::DataType<PRIMITIVE_TYPE>::type);
 
-        // row major (interleaved) to col major (non interleaved;clustered)
-        float* imageData = reinterpret_cast<float*>(image.data);
+        for (size_t c = channelsToCopy; c < cvFeatures->numberOfChannels(); ++c)
+            cvFeatures->channels[c].setTo(0);
 
-        float* const redChannel = I;
-        float* const greenChannel = I + width * height;
-        float* const blueChannel = I + 2 * width * height;
-		float * const depthChannel = I;
-        int colMajorPos = 0, rowMajorPos = 0;
+        for (size_t c = 0; c < channelsToCopy; ++c)
+            planes[c] = cvFeatures->channels[c].template ptr<PRIMITIVE_TYPE>();
 
-        for (int row = 0; row < height; ++row)
-        {
-            for (int col = 0; col < width; ++col)
-            {
-                colMajorPos = col * height + row;
-                rowMajorPos = row * channels * width + col * channels;
+        return static_cast<int>(channelsToCopy);
+    }
 
-				if( channels > 1 )
-				{
-					blueChannel[colMajorPos] = imageData[rowMajorPos];
-					greenChannel[colMajorPos] = imageData[rowMajorPos + 1];
-					redChannel[colMajorPos] = imageData[rowMajorPos + 2];
-				}
-				else if( channels == 1 )
-				{
-					depthChannel[colMajorPos] = imageData[rowMajorPos];
-				}
-            }
-        }
+    template<typename PRIMITIVE_TYPE, class OUT>
+    void cvFhog(const cv::Mat& img, std::shared_ptr<OUT>& cvFeatures, int binSize, int fhogChannelsToCopy = 31,
+        FhogWorkspace& workspace = threadWorkspace())
+    {
+        const int orientations = 9;
+        int channels = img.channels();
 
-        // calc fhog in col major
-        gradMag(I, M, O, height, width, channels, true);
+        // depth maps are read as they are, without a float copy
+        CV_Assert((img.depth() == CV_32F && (channels == 1 || channels == 3)) || (img.depth() == CV_16U && channels == 1));
 
-        if (fhogChannelsToCopy == 27)
-            fhog(M, O, H, height, width, binSize, orientations, -1, 0.2f, false);
+        PRIMITIVE_TYPE* planes[31];
+        const int channelsToCopy = fhogPlanes(img.size(), cvFeatures, binSize, fhogChannelsToCopy, planes);
+
+        // calc fhog in row major, straight from the interleaved image into the planes
+        if (img.depth() == CV_16U)
+            fhogRowMajor(img.ptr<uint16_t>(), img.step1(), img.rows, img.cols, channels,
+                planes, channelsToCopy, binSize, orientations, 0.2f,
+                fhogChannelsToCopy != 27, workspace.scratch);
         else
-            fhog(M, O, H, height, width, binSize, orientations, -1, 0.2f);
+            fhogRowMajor(img.ptr<float>(), img.step1(), img.rows, img.cols, channels,
+                planes, channelsToCopy, binSize, orientations, 0.2f,
+                fhogChannelsToCopy != 27, workspace.scratch);
+    }
 
-        // only copy the amount of the channels the user wants
-        // or the amount that fits into the output array
-        size_t channelsToCopy = std::min< size_t >(fhogChannelsToCopy, cvFeatures->numberOfChannels());
+    // compute the gradients of the rows of img for cvFhogWindow into M (CV_32F) and O (CV_32S),
+    // both allocated like img; separate row ranges may be computed concurrently
+    inline void cvFhogGradients(const cv::Mat& img, cv::Mat& M, cv::Mat& O, int binSize, const cv::Range& rows,
+        FhogWorkspace& workspace = threadWorkspace())
+    {
+        const int orientations = 9;
+        int channels = img.channels();
 
-        for (size_t c = 0; c < channelsToCopy; ++c)
-        {
-            cv::Mat_<PRIMITIVE_TYPE> m(heightBin, widthBin);
-            cvFeatures->channels[c] = m;
-        }
+        CV_Assert((img.depth() == CV_32F && (channels == 1 || channels == 3)) || (img.depth() == CV_16U && channels == 1));
+        CV_Assert(M.type() == CV_32FC1 && O.type() == CV_32SC1 && M.size() == img.size() && O.size() == img.size());
+        CV_Assert(M.step1() == O.step1() && rows.start >= 0 && rows.end <= img.rows);
 
-        PRIMITIVE_TYPE* cdata = 0;
-        //col major to row major with separate channels
-        for (size_t c = 0; c < channelsToCopy; ++c)
-        {
-            float* Hc = H + widthBin * heightBin * c;
-            cdata = reinterpret_cast<PRIMITIVE_TYPE*>(cvFeatures->channels[c].data);
+        if (img.depth() == CV_16U)
+            fhogGradients(img.ptr<uint16_t>(), img.step1(), img.rows, img.cols, channels, rows.start, rows.end,
+                M.ptr<float>(), O.ptr<int>(), M.step1(), binSize, orientations, workspace.scratch);
+        else
+            fhogGradients(img.ptr<float>(), img.step1(), img.rows, img.cols, channels, rows.start, rows.end,
+                M.ptr<float>(), O.ptr<int>(), M.step1(), binSize, orientations, workspace.scratch);
+    }
 
-            for (int row = 0; row < heightBin; ++row)
-                for (int col = 0; col < widthBin; ++col)
+    // cvFhog of img(window), binning the gradients M and O of img from cvFhogGradients;
+    // the result equals cvFhog on a copy of the window
+    template<typename PRIMITIVE_TYPE, class OUT>
+    void cvFhogWindow(const cv::Mat& img, const cv::Mat& M, const cv::Mat& O, const cv::Rect& window,
+        std::shared_ptr<OUT>& cvFeatures, int binSize, int fhogChannelsToCopy = 31,
+        FhogWorkspace& workspace = threadWorkspace())
+    {
+        const int orientations = 9;
+        int channels = img.channels();
 
-                    cdata[row * widthBin + col] = Hc[row + heightBin * col];
-        }
+        CV_Assert((img.depth() == CV_32F && (channels == 1 || channels == 3)) || (img.depth() == CV_16U && channels == 1));
+        CV_Assert(M.type() == CV_32FC1 && O.type() == CV_32SC1 && M.size() == img.size() && O.size() == img.size());
+        CV_Assert(M.step1() == O.step1() && (window & cv::Rect(cv::Point(), img.size())) == window);
 
-        wrFree(M);
-        wrFree(O);
-        wrFree(I);
-        wrFree(H);
+        PRIMITIVE_TYPE* planes[31];
+        const int channelsToCopy = fhogPlanes(window.size(), cvFeatures, binSize, fhogChannelsToCopy, planes);
+        const float* const Mw = M.ptr<float>(window.y) + window.x;
+        const int* const Ow = O.ptr<int>(window.y) + window.x;
+
+        if (img.depth() == CV_16U)
+            fhogWindowRowMajor(img.ptr<uint16_t>(window.y) + window.x, img.step1(), window.height, window.width, channels,
+                Mw, Ow, M.step1(), planes, channelsToCopy, binSize, orientations, 0.2f,
+                fhogChannelsToCopy != 27, workspace.scratch);
+        else
+            fhogWindowRowMajor(img.ptr<float>(window.y) + window.x * channels, img.step1(), window.height, window.width, channels,
+                Mw, Ow, M.step1(), planes, channelsToCopy, binSize, orientations, 0.2f,
+                fhogChannelsToCopy != 27, workspace.scratch);
     }
 
     template<typename PRIMITIVE_TYPE, class OUT>
@@ -40,15 +40,28 @@ either expressed or implied, of the FreeBSD Project.
 * Allow disabling of energy channels computation
 * Remove unnecessary code
 + author: Luka Cehovin: Fix equal results on AMD and Intel CPUs
+* Add fhogRowMajor computing FHOG on interleaved images without transposition
+* Add avx2 and avx512 gradient kernels for fhogRowMajor, selected via cpuid
+* Reuse the scratch memory of fhogRowMajor across calls (see FhogWorkspace)
+* Compute fhogRowMajor on uint16 depth maps directly, skipping missing depth
+* Split the gradients from the binning of fhogRowMajor, for windows sharing one gradient pass
 
 TODO: Fix hackfixes properly; see function fhog and grad1...
 *******************************************************************************/
 #include "gradientMex.hpp"
 #include <math.h>
+#include <algorithm>
+#include <cmath>
 #include "string.h"
 #include "sse.hpp"
 #include <iostream>
 
+// wider kernels are compiled per function and selected at runtime
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PIOTR_CPU_DISPATCH
+#include <immintrin.h>
+#endif
+
 #define PI 3.14159265f
 
 namespace piotr {
@@ -522,6 +535,620 @@ namespace piotr {
         wrFree(R2); // todo check
     }
 
+    // one row of input for the gradient kernels below; the channels of each
+    // row are separate planes in the order of gradMag, depth maps are read in place
+    struct GradientRow {
+        const float * const *above, * const *row, * const *below;
+        const uint16_t *depthAbove, *depthRow, *depthBelow;
+        int d, w, w0; float ry;
+        const float *acost; float oMult, norm; int nOrients2;
+    };
+
+    // compute the normalized gradient magnitude M0 and nearest full orientation
+    // bin O0 of the pixels x < w0 of a row (see gradMag and gradQuantize)
+    typedef void(*GradientRowKernel)(const GradientRow &g, float *M0, int *O0);
+
+    // compute M0 and O0 of a single pixel from its gradient
+    inline void orientationPixel(const GradientRow &g, float gx, float gy, float m2, int x, float *M0, int *O0) {
+        const float m = std::max(std::sqrt(m2), 1e-7f);
+        float gxn = gx / m * 10000.0f;
+        if (std::signbit(gy)) gxn = -gxn;
+        float ori = g.acost[(int)gxn];
+        if (gy < 0) ori += PI;
+
+        int o0 = (int)(ori*g.oMult + .5f);
+        if (o0 >= g.nOrients2) o0 = 0;
+        M0[x] = m*g.norm; O0[x] = o0;
+    }
+
+    // compute M0 and O0 of a single pixel, also handles the image borders
+    inline void gradientPixel(const GradientRow &g, int x, float *M0, int *O0) {
+        const int xl = (x == 0) ? x : x - 1, xr = (x == g.w - 1) ? x : x + 1;
+        const float rx = (x == 0 || x == g.w - 1) ? 1.f : .5f;
+        float gx = 0, gy = 0, m2 = 0;
+
+        // gradient with the maximum squared magnitude over the channels
+        for (int c = 0; c < g.d; c++) {
+            const float cgx = (g.row[c][xr] - g.row[c][xl])*rx;
+            const float cgy = (g.below[c][x] - g.above[c][x])*g.ry;
+            const float cm2 = cgx*cgx + cgy*cgy;
+            if (c == 0 || cm2 > m2) { gx = cgx; gy = cgy; m2 = cm2; }
+        }
+
+        orientationPixel(g, gx, gy, m2, x, M0, O0);
+    }
+
+    // compute M0 and O0 of a single depth pixel, also handles the image borders;
+    // missing (zero) neighbours are replaced by the pixel itself, which turns the
+    // central difference into a one sided one as at the borders, and missing
+    // pixels have no gradient
+    inline void depthGradientPixel(const GradientRow &g, int x, float *M0, int *O0) {
+        const int xl = (x == 0) ? x : x - 1, xr = (x == g.w - 1) ? x : x + 1;
+        const int c = g.depthRow[x];
+        int l = g.depthRow[xl], r = g.depthRow[xr], a = g.depthAbove[x], b = g.depthBelow[x];
+        const float rx = (x == 0 || x == g.w - 1 || l == 0 || r == 0) ? 1.f : .5f;
+        const float ry = (a == 0 || b == 0) ? 1.f : g.ry;
+
+        if (l == 0) l = c;
+        if (r == 0) r = c;
+        if (a == 0) a = c;
+        if (b == 0) b = c;
+
+        const float gx = (c == 0) ? 0.f : (r - l)*rx, gy = (c == 0) ? 0.f : (b - a)*ry;
+        orientationPixel(g, gx, gy, gx*gx + gy*gy, x, M0, O0);
+    }
+
+    // gradientPixel or depthGradientPixel, picked by the pixel type of the image
+    inline void gradientPixelOf(const GradientRow &g, int x, float *M0, int *O0, const float *) {
+        gradientPixel(g, x, M0, O0);
+    }
+
+    inline void gradientPixelOf(const GradientRow &g, int x, float *M0, int *O0, const uint16_t *) {
+        depthGradientPixel(g, x, M0, O0);
+    }
+
+    // compute M0 and O0 of 4 pixels from their gradients (uses sse)
+    inline void orientationSse(const GradientRow &g, __m128 gx, __m128 gy, __m128 m2, int x, float *M0, int *O0) {
+        int idx[4];
+        __m128 m, ori; __m128i o0;
+
+        m = MAX_SSE(SQRT(m2), SET(1e-7f));
+        _mm_storeu_si128((__m128i*) idx, CVT(XOR(MUL(DIV(gx, m), SET(10000.0f)), AND(gy, SET(-0.f)))));
+        ori = SET(g.acost[idx[3]], g.acost[idx[2]], g.acost[idx[1]], g.acost[idx[0]]);
+        ori = ADD(ori, AND(CMPLT(gy, SET(0.f)), SET(PI)));
+        o0 = CVT(ADD(MUL(ori, SET(g.oMult)), SET(.5f)));
+        o0 = AND(CMPGT(SET(g.nOrients2), o0), o0);
+        _mm_storeu_si128((__m128i*) (O0 + x), o0);
+        STRu(M0[x], MUL(m, SET(g.norm)));
+    }
+
+    // gradient kernel for 4 pixels at a time (uses sse)
+    void gradientRowSse(const GradientRow &g, float *M0, int *O0) {
+        const int end = std::min(g.w0, g.w - 1);
+        int x = 0;
+        __m128 gx, gy, m2, cgx, cgy, cm2, mk;
+
+        // the borders and the remainder without sse
+        if (x < g.w0) gradientPixel(g, x++, M0, O0);
+        for (; x + 4 <= end; x += 4) {
+            for (int c = 0; c < g.d; c++) {
+                cgx = MUL(SUB(LDu(g.row[c][x + 1]), LDu(g.row[c][x - 1])), SET(.5f));
+                cgy = MUL(SUB(LDu(g.below[c][x]), LDu(g.above[c][x])), SET(g.ry));
+                cm2 = ADD(MUL(cgx, cgx), MUL(cgy, cgy));
+                if (c == 0) { gx = cgx; gy = cgy; m2 = cm2; continue; }
+                mk = CMPGT(cm2, m2);
+                m2 = OR(AND(mk, cm2), ANDNOT(mk, m2));
+                gx = OR(AND(mk, cgx), ANDNOT(mk, gx));
+                gy = OR(AND(mk, cgy), ANDNOT(mk, gy));
+            }
+            orientationSse(g, gx, gy, m2, x, M0, O0);
+        }
+        for (; x < g.w0; x++) gradientPixel(g, x, M0, O0);
+    }
+
+    // depth gradient kernel for 4 pixels at a time (uses sse), see depthGradientPixel
+    void depthGradientRowSse(const GradientRow &g, float *M0, int *O0) {
+        const int end = std::min(g.w0, g.w - 1);
+        const __m128i zero = _mm_setzero_si128();
+        int x = 0;
+        __m128i c, l, r, a, b, lm, rm, am, bm;
+        __m128 gx, gy;
+
+        // 4 depth values widened to 32 bit
+        auto load = [&zero](const uint16_t *p) { return _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*) p), zero); };
+        auto select = [](__m128i mask, __m128i y, __m128i n) { return _mm_or_si128(_mm_and_si128(mask, y), _mm_andnot_si128(mask, n)); };
+
+        if (x < g.w0) depthGradientPixel(g, x++, M0, O0);
+        for (; x + 4 <= end; x += 4) {
+            c = load(g.depthRow + x);
+            l = load(g.depthRow + x - 1); r = load(g.depthRow + x + 1);
+            a = load(g.depthAbove + x); b = load(g.depthBelow + x);
+            lm = _mm_cmpeq_epi32(l, zero); rm = _mm_cmpeq_epi32(r, zero);
+            am = _mm_cmpeq_epi32(a, zero); bm = _mm_cmpeq_epi32(b, zero);
+            gx = MUL(CVT(_mm_sub_epi32(select(rm, c, r), select(lm, c, l))),
+                OR(AND(_mm_castsi128_ps(_mm_or_si128(lm, rm)), SET(1.f)), ANDNOT(_mm_castsi128_ps(_mm_or_si128(lm, rm)), SET(.5f))));
+            gy = MUL(CVT(_mm_sub_epi32(select(bm, c, b), select(am, c, a))),
+                OR(AND(_mm_castsi128_ps(_mm_or_si128(am, bm)), SET(1.f)), ANDNOT(_mm_castsi128_ps(_mm_or_si128(am, bm)), SET(g.ry))));
+            gx = ANDNOT(_mm_castsi128_ps(_mm_cmpeq_epi32(c, zero)), gx);
+            gy = ANDNOT(_mm_castsi128_ps(_mm_cmpeq_epi32(c, zero)), gy);
+            orientationSse(g, gx, gy, ADD(MUL(gx, gx), MUL(gy, gy)), x, M0, O0);
+        }
+        for (; x < g.w0; x++) depthGradientPixel(g, x, M0, O0);
+    }
+
+#ifdef PIOTR_CPU_DISPATCH
+    // compute M0 and O0 of 8 pixels from their gradients (uses avx2)
+    __attribute__((target("avx2")))
+    inline void orientationAvx2(const GradientRow &g, __m256 gx, __m256 gy, __m256 m2, int x, float *M0, int *O0) {
+        __m256 m, ori; __m256i o0;
+
+        m = _mm256_max_ps(_mm256_sqrt_ps(m2), _mm256_set1_ps(1e-7f));
+        ori = _mm256_xor_ps(_mm256_mul_ps(_mm256_div_ps(gx, m), _mm256_set1_ps(10000.0f)), _mm256_and_ps(gy, _mm256_set1_ps(-0.f)));
+        ori = _mm256_i32gather_ps(g.acost, _mm256_cvttps_epi32(ori), 4);
+        ori = _mm256_add_ps(ori, _mm256_and_ps(_mm256_cmp_ps(gy, _mm256_setzero_ps(), _CMP_LT_OQ), _mm256_set1_ps(PI)));
+        o0 = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(ori, _mm256_set1_ps(g.oMult)), _mm256_set1_ps(.5f)));
+        o0 = _mm256_and_si256(_mm256_cmpgt_epi32(_mm256_set1_epi32(g.nOrients2), o0), o0);
+        _mm256_storeu_si256((__m256i*) (O0 + x), o0);
+        _mm256_storeu_ps(M0 + x, _mm256_mul_ps(m, _mm256_set1_ps(g.norm)));
+    }
+
+    // gradient kernel for 8 pixels at a time (uses avx2)
+    __attribute__((target("avx2")))
+    void gradientRowAvx2(const GradientRow &g, float *M0, int *O0) {
+        const int end = std::min(g.w0, g.w - 1);
+        int x = 0;
+        __m256 gx, gy, m2, cgx, cgy, cm2, mk;
+
+        if (x < g.w0) gradientPixel(g, x++, M0, O0);
+        for (; x + 8 <= end; x += 8) {
+            for (int c = 0; c < g.d; c++) {
+                cgx = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(g.row[c] + x + 1), _mm256_loadu_ps(g.row[c] + x - 1)), _mm256_set1_ps(.5f));
+                cgy = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(g.below[c] + x), _mm256_loadu_ps(g.above[c] + x)), _mm256_set1_ps(g.ry));
+                cm2 = _mm256_add_ps(_mm256_mul_ps(cgx, cgx), _mm256_mul_ps(cgy, cgy));
+                if (c == 0) { gx = cgx; gy = cgy; m2 = cm2; continue; }
+                mk = _mm256_cmp_ps(cm2, m2, _CMP_GT_OQ);
+                m2 = _mm256_blendv_ps(m2, cm2, mk);
+                gx = _mm256_blendv_ps(gx, cgx, mk);
+                gy = _mm256_blendv_ps(gy, cgy, mk);
+            }
+            orientationAvx2(g, gx, gy, m2, x, M0, O0);
+        }
+        for (; x < g.w0; x++) gradientPixel(g, x, M0, O0);
+    }
+
+    // depth gradient kernel for 8 pixels at a time (uses avx2), see depthGradientPixel
+    __attribute__((target("avx2")))
+    void depthGradientRowAvx2(const GradientRow &g, float *M0, int *O0) {
+        const int end = std::min(g.w0, g.w - 1);
+        const __m256i zero = _mm256_setzero_si256();
+        int x = 0;
+        __m256i c, l, r, a, b, lm, rm, am, bm;
+        __m256 gx, gy;
+
+        if (x < g.w0) depthGradientPixel(g, x++, M0, O0);
+        for (; x + 8 <= end; x += 8) {
+            c = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*) (g.depthRow + x)));
+            l = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*) (g.depthRow + x - 1)));
+            r = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*) (g.depthRow + x + 1)));
+            a = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*) (g.depthAbove + x)));
+            b = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*) (g.depthBelow + x)));
+            lm = _mm256_cmpeq_epi32(l, zero); rm = _mm256_cmpeq_epi32(r, zero);
+            am = _mm256_cmpeq_epi32(a, zero); bm = _mm256_cmpeq_epi32(b, zero);
+            gx = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_blendv_epi8(r, c, rm), _mm256_blendv_epi8(l, c, lm))),
+                _mm256_blendv_ps(_mm256_set1_ps(.5f), _mm256_set1_ps(1.f), _mm256_castsi256_ps(_mm256_or_si256(lm, rm))));
+            gy = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_blendv_epi8(b, c, bm), _mm256_blendv_epi8(a, c, am))),
+                _mm256_blendv_ps(_mm256_set1_ps(g.ry), _mm256_set1_ps(1.f), _mm256_castsi256_ps(_mm256_or_si256(am, bm))));
+            gx = _mm256_andnot_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(c, zero)), gx);
+            gy = _mm256_andnot_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(c, zero)), gy);
+            orientationAvx2(g, gx, gy, _mm256_add_ps(_mm256_mul_ps(gx, gx), _mm256_mul_ps(gy, gy)), x, M0, O0);
+        }
+        for (; x < g.w0; x++) depthGradientPixel(g, x, M0, O0);
+    }
+
+    // compute M0 and O0 of 16 pixels from their gradients (uses avx512f)
+    __attribute__((target("avx512f")))
+    inline void orientationAvx512(const GradientRow &g, __m512 gx, __m512 gy, __m512 m2, int x, float *M0, int *O0) {
+        __m512 m, ori; __m512i o0, sign;
+
+        m = _mm512_max_ps(_mm512_sqrt_ps(m2), _mm512_set1_ps(1e-7f));
+        // avx512f has no float xor, the sign of gy is flipped on the integer bits
+        sign = _mm512_and_si512(_mm512_castps_si512(gy), _mm512_set1_epi32((int)0x80000000));
+        ori = _mm512_mul_ps(_mm512_div_ps(gx, m), _mm512_set1_ps(10000.0f));
+        ori = _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(ori), sign));
+        ori = _mm512_i32gather_ps(_mm512_cvttps_epi32(ori), g.acost, 4);
+        ori = _mm512_mask_add_ps(ori, _mm512_cmp_ps_mask(gy, _mm512_setzero_ps(), _CMP_LT_OQ), ori, _mm512_set1_ps(PI));
+        o0 = _mm512_cvttps_epi32(_mm512_add_ps(_mm512_mul_ps(ori, _mm512_set1_ps(g.oMult)), _mm512_set1_ps(.5f)));
+        o0 = _mm512_maskz_mov_epi32(_mm512_cmplt_epi32_mask(o0, _mm512_set1_epi32(g.nOrients2)), o0);
+        _mm512_storeu_si512(O0 + x, o0);
+        _mm512_storeu_ps(M0 + x, _mm512_mul_ps(m, _mm512_set1_ps(g.norm)));
+    }
+
+    // gradient kernel for 16 pixels at a time (uses avx512f)
+    __attribute__((target("avx512f")))
+    void gradientRowAvx512(const GradientRow &g, float *M0, int *O0) {
+        const int end = std::min(g.w0, g.w - 1);
+        int x = 0;
+        __m512 gx, gy, m2, cgx, cgy, cm2; __mmask16 mk;
+
+        if (x < g.w0) gradientPixel(g, x++, M0, O0);
+        for (; x + 16 <= end; x += 16) {
+            for (int c = 0; c < g.d; c++) {
+                cgx = _mm512_mul_ps(_mm512_sub_ps(_mm512_loadu_ps(g.row[c] + x + 1), _mm512_loadu_ps(g.row[c] + x - 1)), _mm512_set1_ps(.5f));
+                cgy = _mm512_mul_ps(_mm512_sub_ps(_mm512_loadu_ps(g.below[c] + x), _mm512_loadu_ps(g.above[c] + x)), _mm512_set1_ps(g.ry));
+                cm2 = _mm512_add_ps(_mm512_mul_ps(cgx, cgx), _mm512_mul_ps(cgy, cgy));
+                if (c == 0) { gx = cgx; gy = cgy; m2 = cm2; continue; }
+                mk = _mm512_cmp_ps_mask(cm2, m2, _CMP_GT_OQ);
+                m2 = _mm512_mask_blend_ps(mk, m2, cm2);
+                gx = _mm512_mask_blend_ps(mk, gx, cgx);
+                gy = _mm512_mask_blend_ps(mk, gy, cgy);
+            }
+            orientationAvx512(g, gx, gy, m2, x, M0, O0);
+        }
+        for (; x < g.w0; x++) gradientPixel(g, x, M0, O0);
+    }
+
+    // depth gradient kernel for 16 pixels at a time (uses avx512f), see depthGradientPixel
+    __attribute__((target("avx512f")))
+    void depthGradientRowAvx512(const GradientRow &g, float *M0, int *O0) {
+        const int end = std::min(g.w0, g.w - 1);
+        const __m512i zero = _mm512_setzero_si512();
+        int x = 0;
+        __m512i c, l, r, a, b;
+        __m512 gx, gy;
+        __mmask16 lm, rm, am, bm, cm;
+
+        if (x < g.w0) depthGradientPixel(g, x++, M0, O0);
+        for (; x + 16 <= end; x += 16) {
+            c = _mm512_cvtepu16_epi32(_mm256_loadu_si256((const __m256i*) (g.depthRow + x)));
+            l = _mm512_cvtepu16_epi32(_mm256_loadu_si256((const __m256i*) (g.depthRow + x - 1)));
+            r = _mm512_cvtepu16_epi32(_mm256_loadu_si256((const __m256i*) (g.depthRow + x + 1)));
+            a = _mm512_cvtepu16_epi32(_mm256_loadu_si256((const __m256i*) (g.depthAbove + x)));
+            b = _mm512_cvtepu16_epi32(_mm256_loadu_si256((const __m256i*) (g.depthBelow + x)));
+            lm = _mm512_cmpeq_epi32_mask(l, zero); rm = _mm512_cmpeq_epi32_mask(r, zero);
+            am = _mm512_cmpeq_epi32_mask(a, zero); bm = _mm512_cmpeq_epi32_mask(b, zero);
+            cm = _mm512_cmpeq_epi32_mask(c, zero);
+            gx = _mm512_mul_ps(_mm512_cvtepi32_ps(_mm512_sub_epi32(_mm512_mask_blend_epi32(rm, r, c), _mm512_mask_blend_epi32(lm, l, c))),
+                _mm512_mask_blend_ps(lm | rm, _mm512_set1_ps(.5f), _mm512_set1_ps(1.f)));
+            gy = _mm512_mul_ps(_mm512_cvtepi32_ps(_mm512_sub_epi32(_mm512_mask_blend_epi32(bm, b, c), _mm512_mask_blend_epi32(am, a, c))),
+                _mm512_mask_blend_ps(am | bm, _mm512_set1_ps(g.ry), _mm512_set1_ps(1.f)));
+            gx = _mm512_maskz_mov_ps((__mmask16) ~cm, gx);
+            gy = _mm512_maskz_mov_ps((__mmask16) ~cm, gy);
+            orientationAvx512(g, gx, gy, _mm512_add_ps(_mm512_mul_ps(gx, gx), _mm512_mul_ps(gy, gy)), x, M0, O0);
+        }
+        for (; x < g.w0; x++) depthGradientPixel(g, x, M0, O0);
+    }
+#endif
+
+    // select the widest gradient kernel supported by the cpu once, sse is the fallback;
+    // the pointer only selects the kernels for the pixel type of the image
+    GradientRowKernel gradientRowKernel(const float *) {
+        static const GradientRowKernel kernel = []() -> GradientRowKernel {
+#ifdef PIOTR_CPU_DISPATCH
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx512f"))
+                return gradientRowAvx512;
+            if (__builtin_cpu_supports("avx2"))
+                return gradientRowAvx2;
+#endif
+            return gradientRowSse;
+        }();
+
+        return kernel;
+    }
+
+    GradientRowKernel gradientRowKernel(const uint16_t *) {
+        static const GradientRowKernel kernel = []() -> GradientRowKernel {
+#ifdef PIOTR_CPU_DISPATCH
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx512f"))
+                return depthGradientRowAvx512;
+            if (__builtin_cpu_supports("avx2"))
+                return depthGradientRowAvx2;
+#endif
+            return depthGradientRowSse;
+        }();
+
+        return kernel;
+    }
+
+    // point the float kernels at rows y - 1, y and y + 1, loading the columns
+    // x0 <= x < x1 of the rows from..y + 1 as planes in the order of gradMag into
+    // a three row ring; the rows of single channel images are used in place
+    inline void loadGradientRows(GradientRow &g, const float * const I, size_t step, int y, int h,
+        int from, int x0, int x1, float * const ring, const float ** const channels) {
+        const int d = g.d, w = g.w;
+
+        for (int row = from; row <= std::min(y + 1, h - 1); row++) {
+            const float * const src = I + row*step;
+            const float ** const dst = &channels[(row % 3)*d];
+            for (int c = 0; c < d; c++) {
+                if (d == 1) { dst[c] = src; continue; }
+                float * const plane = &ring[((row % 3)*d + c)*w];
+                for (int i = x0; i < x1; i++)
+                    plane[i] = src[i*d + d - 1 - c];
+                dst[c] = plane;
+            }
+        }
+
+        g.above = &channels[(std::max(y - 1, 0) % 3)*d];
+        g.row = &channels[(y % 3)*d];
+        g.below = &channels[(std::min(y + 1, h - 1) % 3)*d];
+    }
+
+    // point the depth kernels at rows y - 1, y and y + 1 of the map itself
+    inline void loadGradientRows(GradientRow &g, const uint16_t * const I, size_t step, int y, int h,
+        int, int, int, float * const, const float ** const) {
+        g.depthAbove = I + std::max(y - 1, 0)*step;
+        g.depthRow = I + y*step;
+        g.depthBelow = I + std::min(y + 1, h - 1)*step;
+    }
+
+    FhogWorkspace& threadWorkspace() {
+        thread_local FhogWorkspace workspace;
+        return workspace;
+    }
+
+    // the binning and normalization of fhogRowMajor; rowGradients(g, y, M0, O0, ring, channels)
+    // fills M0 and O0 with the gradients of the pixels x < w0 of row y < h0, see GradientRow,
+    // using ring and channels as the row ring of loadGradientRows
+    template<typename T, typename RowGradients>
+    void fhogRows(int h, int w, int d, T * const * const H, int nH, int binSize, int nOrients,
+        float clip, bool calcEnergy, AlignedBuffer& scratch, const RowGradients& rowGradients)
+    {
+        const int hb = h / binSize, wb = w / binSize, h0 = hb*binSize, w0 = wb*binSize;
+        const int nOrients2 = nOrients * 2, nb = wb*hb, hb1 = hb + 1, wb1 = wb + 1;
+        const float s = (float)binSize, sInv = 1 / s, sInv2 = 1 / s / s;
+        const float oMult = (float)nOrients2 / (2 * PI), init = (0 + .5f)*sInv - 0.5f;
+        const float r = .2357f;
+        int x, y, o, k;
+
+        if (nb == 0)
+            return;
+
+        // carve all buffers out of the grow-only scratch memory
+        size_t size = 0;
+        auto carve = [&size](size_t bytes) { const size_t offset = size; size += (bytes + 63) & ~size_t(63); return offset; };
+        const size_t xb0sAt = carve(w0*sizeof(int)), xdsAt = carve(w0*sizeof(float));
+        const size_t ringAt = carve((d > 1 ? 3 * d*w : 0)*sizeof(float)), channelsAt = carve(3 * d*sizeof(float*));
+        const size_t M0At = carve(w0*sizeof(float)), O0At = carve(w0*sizeof(int));
+        const size_t R1At = carve(nb*nOrients2*sizeof(float)), R2At = carve(nb*nOrients*sizeof(float));
+        const size_t NAt = carve(hb1*wb1*sizeof(float));
+        const size_t NcAt = carve(4 * nb*sizeof(float)), EAt = carve(4 * nb*sizeof(float));
+        char * const base = (char*)scratch.reserve(size);
+
+        int * const xb0s = (int*)(base + xb0sAt);
+        float * const xds = (float*)(base + xdsAt), * const ring = (float*)(base + ringAt);
+        const float ** const channels = (const float**)(base + channelsAt);
+        float * const M0 = (float*)(base + M0At);
+        int * const O0 = (int*)(base + O0At);
+        float * const R1 = (float*)(base + R1At), * const R2 = (float*)(base + R2At), * const N = (float*)(base + NAt);
+        float * const Nc = (float*)(base + NcAt), * const E = (float*)(base + EAt);
+
+        // left bin and interpolation weight of every column (see gradHist)
+        float xb = init;
+
+        for (x = 0; x < w0; x++) {
+            xb0s[x] = (xb >= 0) ? (int)xb : -1;
+            xds[x] = xb - xb0s[x];
+            xb += sInv;
+        }
+
+        GradientRow g;
+        g.d = d; g.w = w; g.w0 = w0;
+        g.acost = acosTable(); g.oMult = oMult; g.norm = sInv2; g.nOrients2 = nOrients2;
+
+        // unnormalized contrast sensitive histograms, the orientations of a cell are adjacent
+        std::fill(R1, R1 + nb*nOrients2, 0.f);
+        float yb = init;
+
+        for (y = 0; y < h0; y++) {
+            // leading rows have no top bin, final rows no bottom bin
+            const int yb0 = (y < binSize / 2) ? -1 : (int)yb;
+            const bool hasTop = yb0 >= 0, hasBottom = yb0 < hb - 1;
+            const float yd = yb - yb0;
+            yb += sInv;
+
+            // gradient magnitude and orientation bin of every pixel of the row
+            rowGradients(g, y, M0, O0, ring, channels);
+
+            const int top = yb0*wb*nOrients2, bottom = top + wb*nOrients2;
+
+            for (x = 0; x < w0; x++) {
+                // trilinear spatial weights (see gradHist)
+                const int o0 = O0[x];
+                const float m0 = M0[x], xd = xds[x], xyd = xd*yd;
+                const int xb0 = xb0s[x];
+
+                if (xb0 >= 0) {
+                    if (hasTop) R1[top + xb0*nOrients2 + o0] += (1 - xd - yd + xyd)*m0;
+                    if (hasBottom) R1[bottom + xb0*nOrients2 + o0] += (yd - xyd)*m0;
+                }
+                if (xb0 < wb - 1) {
+                    if (hasTop) R1[top + (xb0 + 1)*nOrients2 + o0] += (xd - xyd)*m0;
+                    if (hasBottom) R1[bottom + (xb0 + 1)*nOrients2 + o0] += xyd*m0;
+                }
+            }
+        }
+
+        // normalize boundary bins which only get 7/8 of weight of interior bins
+        for (y = 0; y < hb; y++) for (x = 0; x < wb; x++) {
+            const int edges = (x == 0) + (y == 0) + (x == wb - 1) + (y == hb - 1);
+            float * const R1c = R1 + (y*wb + x)*nOrients2;
+            for (k = 0; k < edges; k++) for (o = 0; o < nOrients2; o++)
+                R1c[o] *= 8.f / 7.f;
+        }
+
+        // contrast insensitive histograms and their 2x2 block normalization values (see hogNormMatrix)
+        std::fill(N, N + hb1*wb1, 0.f);
+        const float eps = 1e-4f / 4 / binSize / binSize / binSize / binSize;
+
+        for (y = 0; y < hb; y++) for (x = 0; x < wb; x++) {
+            const float * const R1c = R1 + (y*wb + x)*nOrients2;
+            float * const R2c = R2 + (y*wb + x)*nOrients;
+            float &n = N[(y + 1)*wb1 + x + 1];
+            for (o = 0; o < nOrients; o++) {
+                R2c[o] = R1c[o] + R1c[o + nOrients];
+                n += R2c[o] * R2c[o];
+            }
+        }
+        for (y = 0; y < hb - 1; y++) for (x = 0; x < wb - 1; x++) {
+            float * const n = N + (y + 1)*wb1 + x + 1;
+            *n = 1 / std::sqrt(n[0] + n[wb1] + n[1] + n[wb1 + 1] + eps);
+        }
+
+#define NXY(x, y) N[(y)*wb1 + (x)]
+        int dx, dy;
+        x = 0;       dx = 1;  dy = 1;  y = 0;                        NXY(x, y) = NXY(x + dx, y + dy);
+        x = 0;       dx = 1;  dy = 0;  for (y = 0; y < hb1; y++)     NXY(x, y) = NXY(x + dx, y + dy);
+        x = 0;       dx = 1;  dy = -1; y = hb1 - 1;                  NXY(x, y) = NXY(x + dx, y + dy);
+        x = wb1 - 1; dx = -1; dy = 1;  y = 0;                        NXY(x, y) = NXY(x + dx, y + dy);
+        x = wb1 - 1; dx = -1; dy = 0;  for (y = 0; y < hb1; y++)     NXY(x, y) = NXY(x + dx, y + dy);
+        x = wb1 - 1; dx = -1; dy = -1; y = hb1 - 1;                  NXY(x, y) = NXY(x + dx, y + dy);
+        y = 0;       dx = 0;  dy = 1;  for (x = 0; x < wb1; x++)     NXY(x, y) = NXY(x + dx, y + dy);
+        y = hb1 - 1; dx = 0;  dy = -1; for (x = 0; x < wb1; x++)     NXY(x, y) = NXY(x + dx, y + dy);
+
+        // the four normalization values of every cell as planes
+        for (y = 0; y < hb; y++) for (x = 0; x < wb; x++) {
+            const int i = y*wb + x;
+            Nc[i] = NXY(x + 1, y + 1); Nc[nb + i] = NXY(x + 1, y);
+            Nc[2 * nb + i] = NXY(x, y + 1); Nc[3 * nb + i] = NXY(x, y);
+        }
+#undef NXY
+
+        // normalized histograms and texture channels (see hogChannels), one channel
+        // at a time so that every output plane is written in order
+        std::fill(E, E + 4 * nb, 0.f);
+
+        for (o = 0; o < nOrients2 + nOrients; o++) {
+            const bool sensitive = o < nOrients2;
+            const float * const R = sensitive ? R1 + o : R2 + o - nOrients2;
+            const int stride = sensitive ? nOrients2 : nOrients;
+            T * const Ho = (o < nH) ? H[o] : 0;
+
+            for (int i = 0; i < nb; i++) {
+                const float v = R[i*stride];
+                const float t0 = std::min(v*Nc[i], clip), t1 = std::min(v*Nc[nb + i], clip);
+                const float t2 = std::min(v*Nc[2 * nb + i], clip), t3 = std::min(v*Nc[3 * nb + i], clip);
+                if (Ho) Ho[i] = (((0.f + t0*.5f) + t1*.5f) + t2*.5f) + t3*.5f;
+                if (sensitive) {
+                    E[i] += t0*r; E[nb + i] += t1*r; E[2 * nb + i] += t2*r; E[3 * nb + i] += t3*r;
+                }
+            }
+        }
+        for (k = 0; k < 4; k++) if (nOrients * 3 + k < nH) {
+            T * const Hk = H[nOrients * 3 + k];
+            for (int i = 0; i < nb; i++)
+                Hk[i] = calcEnergy ? E[k*nb + i] : 0.f;
+        }
+    }
+
+    // compute FHOG features of a row major (interleaved) image directly
+    // into row major channel planes H[0..nH-1] of hb x wb cells (nH <= 31);
+    // same as gradMag + fhog with softBin=-1 on the transposed image, except
+    // that each histogram bin sums its pixels in row instead of column order;
+    // uint16 images are single channel depth maps in which 0 is missing depth
+    template<typename T, typename P>
+    void fhogRowMajor(const P * const I, size_t step, int h, int w, int d,
+        T * const * const H, int nH, int binSize, int nOrients, float clip,
+        bool calcEnergy, AlignedBuffer& scratch)
+    {
+        const GradientRowKernel kernel = gradientRowKernel(I);
+
+        fhogRows(h, w, d, H, nH, binSize, nOrients, clip, calcEnergy, scratch,
+            [=](GradientRow &g, int y, float *M0, int *O0, float *ring, const float **channels) {
+                loadGradientRows(g, I, step, y, h, (y == 0) ? 0 : y + 1, 0, w, ring, channels);
+                g.ry = (y == 0 || y == h - 1) ? 1.f : .5f;
+                kernel(g, M0, O0);
+            });
+    }
+
+    // compute the gradient magnitude M and orientation bin O of the rows y0 <= y < y1
+    // of a row major image as fhogRowMajor does, for windows binned by fhogWindowRowMajor
+    template<typename P>
+    void fhogGradients(const P * const I, size_t step, int h, int w, int d, int y0, int y1,
+        float * const M, int * const O, size_t gradStep, int binSize, int nOrients, AlignedBuffer& scratch)
+    {
+        const float s = (float)binSize;
+
+        size_t size = 0;
+        auto carve = [&size](size_t bytes) { const size_t offset = size; size += (bytes + 63) & ~size_t(63); return offset; };
+        const size_t ringAt = carve((d > 1 ? 3 * d*w : 0)*sizeof(float)), channelsAt = carve(3 * d*sizeof(float*));
+        char * const base = (char*)scratch.reserve(size);
+        float * const ring = (float*)(base + ringAt);
+        const float ** const channels = (const float**)(base + channelsAt);
+
+        GradientRow g;
+        g.d = d; g.w = w; g.w0 = w;
+        g.acost = acosTable(); g.oMult = (float)(nOrients * 2) / (2 * PI); g.norm = 1 / s / s; g.nOrients2 = nOrients * 2;
+        const GradientRowKernel kernel = gradientRowKernel(I);
+
+        for (int y = y0; y < y1; y++) {
+            loadGradientRows(g, I, step, y, h, (y == y0) ? std::max(y - 1, 0) : y + 1, 0, w, ring, channels);
+            g.ry = (y == 0 || y == h - 1) ? 1.f : .5f;
+            kernel(g, M + y*gradStep, O + y*gradStep);
+        }
+    }
+
+    // fhogRowMajor of the h x w window at I, binning the gradients M and O of the
+    // image around it (see fhogGradients) at the same position; only the borders
+    // of the window, where its own gradients are one sided, are computed again
+    template<typename T, typename P>
+    void fhogWindowRowMajor(const P * const I, size_t step, int h, int w, int d,
+        const float * const M, const int * const O, size_t gradStep,
+        T * const * const H, int nH, int binSize, int nOrients, float clip,
+        bool calcEnergy, AlignedBuffer& scratch)
+    {
+        const GradientRowKernel kernel = gradientRowKernel(I);
+        const int w0 = (w / binSize)*binSize;
+
+        fhogRows(h, w, d, H, nH, binSize, nOrients, clip, calcEnergy, scratch,
+            [=](GradientRow &g, int y, float *M0, int *O0, float *ring, const float **channels) {
+                if (y == 0 || y == h - 1) {
+                    loadGradientRows(g, I, step, y, h, std::max(y - 1, 0), 0, w, ring, channels);
+                    g.ry = 1.f;
+                    kernel(g, M0, O0);
+                    return;
+                }
+
+                std::copy(M + y*gradStep, M + y*gradStep + w0, M0);
+                std::copy(O + y*gradStep, O + y*gradStep + w0, O0);
+                g.ry = .5f;
+
+                loadGradientRows(g, I, step, y, h, y - 1, 0, std::min(2, w), ring, channels);
+                gradientPixelOf(g, 0, M0, O0, I);
+
+                if (w0 == w && w > 1) {
+                    loadGradientRows(g, I, step, y, h, y - 1, w - 2, w, ring, channels);
+                    gradientPixelOf(g, w - 1, M0, O0, I);
+                }
+            });
+    }
+
+    template void fhogRowMajor<float, float>(const float * const I, size_t step, int h, int w, int d,
+        float * const * const H, int nH, int binSize, int nOrients, float clip, bool calcEnergy, AlignedBuffer& scratch);
+    template void fhogRowMajor<float, uint16_t>(const uint16_t * const I, size_t step, int h, int w, int d,
+        float * const * const H, int nH, int binSize, int nOrients, float clip, bool calcEnergy, AlignedBuffer& scratch);
+    template void fhogRowMajor<double, float>(const float * const I, size_t step, int h, int w, int d,
+        double * const * const H, int nH, int binSize, int nOrients, float clip, bool calcEnergy, AlignedBuffer& scratch);
+    template void fhogRowMajor<double, uint16_t>(const uint16_t * const I, size_t step, int h, int w, int d,
+        double * const * const H, int nH, int binSize, int nOrients, float clip, bool calcEnergy, AlignedBuffer& scratch);
+    template void fhogGradients<float>(const float * const I, size_t step, int h, int w, int d, int y0, int y1,
+        float * const M, int * const O, size_t gradStep, int binSize, int nOrients, AlignedBuffer& scratch);
+    template void fhogGradients<uint16_t>(const uint16_t * const I, size_t step, int h, int w, int d, int y0, int y1,
+        float * const M, int * const O, size_t gradStep, int binSize, int nOrients, AlignedBuffer& scratch);
+    template void fhogWindowRowMajor<float, float>(const float * const I, size_t step, int h, int w, int d,
+        const float * const M, const int * const O, size_t gradStep,
+        float * const * const H, int nH, int binSize, int nOrients, float clip, bool calcEnergy, AlignedBuffer& scratch);
+    template void fhogWindowRowMajor<float, uint16_t>(const uint16_t * const I, size_t step, int h, int w, int d,
+        const float * const M, const int * const O, size_t gradStep,
+        float * const * const H, int nH, int binSize, int nOrients, float clip, bool calcEnergy, AlignedBuffer& scratch);
+    template void fhogWindowRowMajor<double, float>(const float * const I, size_t step, int h, int w, int d,
+        const float * const M, const int * const O, size_t gradStep,
+        double * const * const H, int nH, int binSize, int nOrients, float clip, bool calcEnergy, AlignedBuffer& scratch);
+    template void fhogWindowRowMajor<double, uint16_t>(const uint16_t * const I, size_t step, int h, int w, int d,
+        const float * const M, const int * const O, size_t gradStep,
+        double * const * const H, int nH, int binSize, int nOrients, float clip, bool calcEnergy, AlignedBuffer& scratch);
+
     /******************************************************************************/
 #ifdef MATLAB_MEX_FILE
     // Create [hxwxd] mxArray array, initialize to 0 if c=true
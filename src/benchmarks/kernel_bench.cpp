@@ -0,0 +1,158 @@
+/*
+// License Agreement (3-clause BSD License)
+// Copyright (c) 2016, Jake Hall, Massimo Camplan, Sion Hannuna.
+// Third party copyrights and patents are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the names of the copyright holders nor the names of the contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall copyright holders or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+*/
+
+/*
+Times the kernel correlation of a detection against a cached model, the call
+made on every detection, training step and score, for every kernel
+implementation. The features are random spectra of the size of a typical model:
+by default a 48 x 32 cell grid with the 62 channels of the concatenated HOG
+features of both maps.
+
+Usage: kernel_bench [width height channels iterations]
+
+Prints one CSV line per kernel with the time per correlation and the speedup
+over the Gaussian kernel summed in the spatial domain, followed by the largest
+relative difference between the two Gaussian summations. The precision column
+is the scalar type of the build (see DSKCF_SINGLE_PRECISION), so the output of
+a float and a double build can be put side by side.
+*/
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#include "FFTEngine.hpp"
+#include "GaussianKernel.hpp"
+#include "LinearKernel.hpp"
+#include "PolynomialKernel.hpp"
+
+struct BenchmarkedKernel
+{
+  std::string name;
+  std::shared_ptr< Kernel > kernel;
+};
+
+/**
+ * @returns The spectra of random features with the given grid and number of channels.
+ */
+static std::shared_ptr< FC > randomSpectra( cv::RNG & rng, const cv::Size & grid, int channels )
+{
+  auto features = std::make_shared< FC >( channels );
+  features->allocate( grid, cv::DataType< Real >::type );
+
+  for( cv::Mat & channel : features->channels )
+  {
+    rng.fill( channel, cv::RNG::UNIFORM, -1.0, 1.0 );
+  }
+
+  return FC::dftFeatures( features );
+}
+
+/**
+ * @returns The time of one correlation of xf with the model yf in milliseconds.
+ */
+static double timeCorrelation( const Kernel & kernel, const std::shared_ptr< FC > & xf, const std::shared_ptr< FC > & yf, int iterations,
+  cv::Mat & result )
+{
+  const KernelCache cache = kernel.createCache( yf );
+
+  // Warm up the transforms and the allocator
+  result = kernel.correlation( xf, yf, cache );
+
+  const int64 start = cv::getTickCount();
+
+  for( int i = 0; i < iterations; ++i )
+  {
+    result = kernel.correlation( xf, yf, cache );
+  }
+
+  return ( cv::getTickCount() - start ) * 1000.0 / ( cv::getTickFrequency() * iterations );
+}
+
+int main( int argc, const char ** argv )
+{
+  if( argc != 1 && argc != 5 )
+  {
+    std::cerr << "Usage: " << argv[ 0 ] << " [width height channels iterations]" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  const cv::Size grid = argc == 5 ? cv::Size( std::atoi( argv[ 1 ] ), std::atoi( argv[ 2 ] ) ) : cv::Size( 48, 32 );
+  const int channels = argc == 5 ? std::atoi( argv[ 3 ] ) : 62;
+  const int iterations = argc == 5 ? std::atoi( argv[ 4 ] ) : 200;
+
+  if( grid.area() <= 0 || channels <= 0 || iterations <= 0 )
+  {
+    std::cerr << "The grid, the number of channels and the iterations must be positive" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  cv::RNG rng( 1 );
+  const std::shared_ptr< FC > xf = randomSpectra( rng, grid, channels );
+  const std::shared_ptr< FC > yf = randomSpectra( rng, grid, channels );
+  FFTEngine::getDefault()->prepare( grid, cv::DataType< Real >::type );
+
+  const std::vector< BenchmarkedKernel > kernels = {
+    { "gaussian (spatial sum)", std::make_shared< GaussianKernel >( false ) },
+    { "gaussian (Fourier sum)", std::make_shared< GaussianKernel >( true ) },
+    { "linear", std::make_shared< LinearKernel >() },
+    { "polynomial", std::make_shared< PolynomialKernel >() }
+  };
+
+  std::vector< cv::Mat > results( kernels.size() );
+  double reference = 0.0;
+
+  const std::string precision = sizeof( Real ) == sizeof( float ) ? "float" : "double";
+
+  std::cout << "Kernel,Precision,Width,Height,Channels,MsPerCorrelation,Speedup" << std::endl;
+
+  for( size_t i = 0; i < kernels.size(); ++i )
+  {
+    const double ms = timeCorrelation( *kernels[ i ].kernel, xf, yf, iterations, results[ i ] );
+
+    if( i == 0 )
+    {
+      reference = ms;
+    }
+
+    std::cout << kernels[ i ].name << "," << precision << "," << grid.width << "," << grid.height << "," << channels << ","
+      << ms << "," << reference / ms << std::endl;
+  }
+
+  std::cout << "Largest relative difference of the Gaussian summations: "
+    << cv::norm( results[ 0 ], results[ 1 ], cv::NORM_INF ) / cv::norm( results[ 0 ], cv::NORM_INF ) << std::endl;
+
+  return EXIT_SUCCESS;
+}
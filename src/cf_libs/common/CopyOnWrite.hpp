@@ -0,0 +1,98 @@
+/*
+// License Agreement (3-clause BSD License)
+// Copyright (c) 2016, Jake Hall, Massimo Camplan, Sion Hannuna.
+// Third party copyrights and patents are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the names of the copyright holders nor the names of the contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall copyright holders or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+*/
+
+/*
+CopyOnWrite holds a value which is shared between copies of its holder until
+one of them writes to it. Copying a holder is O(1); the first write through a
+shared holder deep-copies the value, so the other holders never observe it.
+
+The value is deep-copied with its clone() method, as the copy constructors of
+cv::Mat and std::shared_ptr only copy references. A holder must not be copied
+by one thread while another writes through it.
+*/
+
+#ifndef _COPY_ON_WRITE_HPP_
+#define _COPY_ON_WRITE_HPP_
+
+#include <memory>
+
+template< class T >
+class CopyOnWrite
+{
+public:
+  CopyOnWrite() :
+    m_value( std::make_shared< T >() )
+  {
+  }
+
+  explicit CopyOnWrite( const T & value ) :
+    m_value( std::make_shared< T >( value ) )
+  {
+  }
+
+  /**
+   * @returns The value for reading. The reference is invalidated by the next write through this holder.
+   */
+  const T & read() const
+  {
+    return *this->m_value;
+  }
+
+  const T * operator->() const
+  {
+    return this->m_value.get();
+  }
+
+  /**
+   * @returns The value for writing, deep-copied first if it is shared with another holder.
+   */
+  T & write()
+  {
+    if( !this->unique() )
+    {
+      this->m_value = std::make_shared< T >( this->m_value->clone() );
+    }
+
+    return *this->m_value;
+  }
+
+  /**
+   * @returns True if no other holder shares the value.
+   */
+  bool unique() const
+  {
+    return this->m_value.use_count() == 1;
+  }
+private:
+  std::shared_ptr< T > m_value;
+};
+
+#endif
@@ -1,6 +1,6 @@
 #include <opencv2/core.hpp>
 #include <opencv2/imgproc.hpp>
-#include <tbb/parallel_for.h>
+#include "ExecutionPolicy.hpp"
 #include "DepthHistogram.h"
 #include "math_helper.hpp"
 
@@ -138,7 +138,7 @@ const DepthHistogram::Labels DepthHistogram::kmeans( const std::vector< float >
     //Assign each label to the nearest centroid
     //TODO: Investigate possible parallelisation
     //for( int i = 0; i < this->m_bins.rows; i++ )
-    tbb::parallel_for< uint >( 0, this->m_bins.rows, 1,
+    parallelFor< uint >( 0, this->m_bins.rows,
     [&result]( const uint i )
     {
       for( uint j = 0; j < result.centers.size(); j++ )
@@ -153,7 +153,7 @@ const DepthHistogram::Labels DepthHistogram::kmeans( const std::vector< float >
     //Move the centroids to the center of their labels
     //TODO: Investigate possible parallelisation
     //for( uint i = 0; i < result.centers.size(); i++ )
-    tbb::parallel_for< uint >( 0, result.centers.size(), 1,
+    parallelFor< uint >( 0, result.centers.size(),
     [this,&result,&oldCentroids]( const uint i )
     {
       float numerator = 0.0;
@@ -0,0 +1,75 @@
+/*
+// License Agreement (3-clause BSD License)
+// Copyright (c) 2016, Jake Hall, Massimo Camplan, Sion Hannuna.
+// Third party copyrights and patents are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the names of the copyright holders nor the names of the contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall copyright holders or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+*/
+
+#include "ExecutionPolicy.hpp"
+
+#include <opencv2/core/core.hpp>
+
+namespace
+{
+  thread_local const ExecutionPolicy * currentPolicy = nullptr;
+}
+
+const ExecutionPolicy & ExecutionPolicy::current()
+{
+  static const ExecutionPolicy defaultPolicy;
+
+  return currentPolicy ? *currentPolicy : defaultPolicy;
+}
+
+void ExecutionPolicy::applyOpenCvThreads() const
+{
+  if( this->openCvThreads >= 0 )
+  {
+    cv::setNumThreads( this->openCvThreads );
+  }
+}
+
+std::shared_ptr< tbb::task_arena > ExecutionPolicy::createArena() const
+{
+  if( this->arenaConcurrency > 0 )
+  {
+    return std::make_shared< tbb::task_arena >( this->arenaConcurrency );
+  }
+
+  return nullptr;
+}
+
+ExecutionPolicy::Scope::Scope( const ExecutionPolicy & policy ) :
+  m_previous( currentPolicy )
+{
+  currentPolicy = &policy;
+}
+
+ExecutionPolicy::Scope::~Scope()
+{
+  currentPolicy = this->m_previous;
+}
@@ -0,0 +1,159 @@
+/*
+// License Agreement (3-clause BSD License)
+// Copyright (c) 2016, Jake Hall, Massimo Camplan, Sion Hannuna.
+// Third party copyrights and patents are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the names of the copyright holders nor the names of the contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall copyright holders or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+*/
+
+/*
+ExecutionPolicy controls how the data parallel loops of a tracker are scheduled.
+Every loop of the tracker goes through parallelFor or parallelForBlocks, which
+read the policy of the calling thread and re-establish it inside each task, so
+the policy also holds for loops nested in tasks run by TBB worker threads.
+
+When many trackers are run in parallel, the outer level already keeps all cores
+busy; setting sequentialInnerLoops then removes the scheduling overhead of the
+per channel and per bin loops. A tracker may also be pinned to its own
+tbb::task_arena to bound the number of threads it can occupy.
+*/
+#ifndef _EXECUTION_POLICY_HPP_
+#define _EXECUTION_POLICY_HPP_
+
+#include <memory>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+
+struct ExecutionPolicy
+{
+  /** The number of threads of the tracker's task arena, or 0 to use the global TBB pool */
+  int arenaConcurrency = 0;
+
+  /** Run the per channel, per bin and per frame loops sequentially */
+  bool sequentialInnerLoops = false;
+
+  /** The number of iterations of the per channel loops processed by one task */
+  size_t channelGrain = 1;
+
+  /** The number of elements of the tensor wide operations processed by one task */
+  int tensorGrain = 1 << 14;
+
+  /** The number of threads passed to cv::setNumThreads, or -1 to leave OpenCV's setting alone */
+  int openCvThreads = -1;
+
+  /**
+   * @returns The policy of the calling thread, or a default constructed policy if none is set.
+   */
+  static const ExecutionPolicy & current();
+
+  /**
+   * Applies openCvThreads, if set. OpenCV's thread count is process wide, so this
+   * should be called once by the application rather than per tracker.
+   */
+  void applyOpenCvThreads() const;
+
+  /**
+   * @returns A task arena with arenaConcurrency threads, or nullptr if arenaConcurrency is 0.
+   */
+  std::shared_ptr< tbb::task_arena > createArena() const;
+
+  /**
+   * Makes a policy the current policy of the calling thread for the lifetime of the scope.
+   */
+  class Scope
+  {
+  public:
+    explicit Scope( const ExecutionPolicy & policy );
+    ~Scope();
+
+    Scope( const Scope & ) = delete;
+    Scope & operator=( const Scope & ) = delete;
+  private:
+    const ExecutionPolicy * m_previous;
+  };
+};
+
+/**
+ * Calls function( i ) for every i in [ begin, end ), in parallel unless the current
+ * policy asks for sequential inner loops.
+ */
+template< typename Index, typename Function >
+void parallelFor( Index begin, Index end, const Function & function )
+{
+  const ExecutionPolicy policy = ExecutionPolicy::current();
+
+  if( policy.sequentialInnerLoops || end - begin <= 1 )
+  {
+    for( Index i = begin; i < end; ++i )
+    {
+      function( i );
+    }
+
+    return;
+  }
+
+  tbb::parallel_for( tbb::blocked_range< Index >( begin, end, policy.channelGrain ),
+    [&policy, &function]( const tbb::blocked_range< Index > & range ) -> void
+    {
+      ExecutionPolicy::Scope scope( policy );
+
+      for( Index i = range.begin(); i < range.end(); ++i )
+      {
+        function( i );
+      }
+    }
+  );
+}
+
+/**
+ * Calls function( range ) for blocks of about grain iterations covering [ begin, end ),
+ * or once for the whole range if the current policy asks for sequential inner loops.
+ *
+ * @param grain The block size, or 0 to let TBB choose it.
+ */
+template< typename Function >
+void parallelForBlocks( int begin, int end, int grain, const Function & function )
+{
+  const ExecutionPolicy policy = ExecutionPolicy::current();
+
+  if( policy.sequentialInnerLoops || ( grain > 0 && end - begin <= grain ) )
+  {
+    function( tbb::blocked_range< int >( begin, end ) );
+    return;
+  }
+
+  tbb::parallel_for( tbb::blocked_range< int >( begin, end, grain > 0 ? grain : 1 ),
+    [&policy, &function]( const tbb::blocked_range< int > & range ) -> void
+    {
+      ExecutionPolicy::Scope scope( policy );
+      function( range );
+    }
+  );
+}
+
+#endif
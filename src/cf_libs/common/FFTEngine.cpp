@@ -0,0 +1,224 @@
+/*
+// License Agreement (3-clause BSD License)
+// Copyright (c) 2016, Jake Hall, Massimo Camplan, Sion Hannuna.
+// Third party copyrights and patents are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the names of the copyright holders nor the names of the contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall copyright holders or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+*/
+
+#include "FFTEngine.hpp"
+
+#include <atomic>
+
+#include "ExecutionPolicy.hpp"
+
+namespace
+{
+  std::shared_ptr< FFTEngine > & defaultEngine()
+  {
+    static std::shared_ptr< FFTEngine > engine = std::make_shared< OpenCVFFTEngine >();
+    return engine;
+  }
+}
+
+FFTEngine::~FFTEngine()
+{
+}
+
+void FFTEngine::dft( const std::vector< cv::Mat > & src, std::vector< cv::Mat > & dst, int flags )
+{
+  dst.resize( src.size() );
+
+  parallelFor< size_t >( 0, src.size(),
+    [this, &src, &dst, flags]( size_t index ) -> void
+    {
+      this->dft( src[ index ], dst[ index ], flags );
+    }
+  );
+}
+
+void FFTEngine::idft( const std::vector< cv::Mat > & src, std::vector< cv::Mat > & dst, int flags )
+{
+  dst.resize( src.size() );
+
+  parallelFor< size_t >( 0, src.size(),
+    [this, &src, &dst, flags]( size_t index ) -> void
+    {
+      this->idft( src[ index ], dst[ index ], flags );
+    }
+  );
+}
+
+void FFTEngine::prepare( const cv::Size & size, int type, int flags )
+{
+}
+
+std::shared_ptr< FFTEngine > FFTEngine::getDefault()
+{
+  return std::atomic_load( &defaultEngine() );
+}
+
+void FFTEngine::setDefault( const std::shared_ptr< FFTEngine > & engine )
+{
+  CV_Assert( engine );
+  std::atomic_store( &defaultEngine(), engine );
+}
+
+#ifdef FFT_ENGINE_HAL_DFT
+
+void OpenCVFFTEngine::dft( const cv::Mat & src, cv::Mat & dst, int flags )
+{
+  this->transform( src, dst, flags, ( flags & cv::DFT_INVERSE ) != 0 );
+}
+
+void OpenCVFFTEngine::idft( const cv::Mat & src, cv::Mat & dst, int flags )
+{
+  this->transform( src, dst, flags, true );
+}
+
+void OpenCVFFTEngine::prepare( const cv::Size & size, int type, int flags )
+{
+  int forwardType = this->dstType( type, flags, false );
+  int inverseFlags = ( CV_MAT_CN( forwardType ) == 2 && CV_MAT_CN( type ) == 1 ) ? cv::DFT_REAL_OUTPUT : 0;
+  int inverseType = this->dstType( forwardType, inverseFlags, true );
+
+  PlanKey forwardKey = this->planKey( size, type, forwardType, flags, false );
+  PlanKey inverseKey = this->planKey( size, forwardType, inverseType, inverseFlags | cv::DFT_SCALE, true );
+
+  this->releasePlan( forwardKey, this->acquirePlan( forwardKey ) );
+  this->releasePlan( inverseKey, this->acquirePlan( inverseKey ) );
+}
+
+void OpenCVFFTEngine::transform( const cv::Mat & src, cv::Mat & dst, int flags, bool inverse )
+{
+  CV_Assert( src.dims == 2 && ( src.depth() == CV_32F || src.depth() == CV_64F ) );
+
+  int type = this->dstType( src.type(), flags, inverse );
+
+  if( src.data != dst.data )
+  {
+    dst.create( src.size(), type );
+  }
+
+  // A plan only covers continuous, non-overlapping buffers of one layout;
+  // everything else is left to OpenCV
+  if( !src.isContinuous() || !dst.isContinuous() || ( flags & cv::DFT_ROWS ) || src.data == dst.data )
+  {
+    if( inverse )
+    {
+      cv::idft( src, dst, flags );
+    }
+    else
+    {
+      cv::dft( src, dst, flags );
+    }
+
+    return;
+  }
+
+  PlanKey key = this->planKey( src.size(), src.type(), type, flags, inverse );
+  cv::Ptr< cv::hal::DFT2D > plan = this->acquirePlan( key );
+
+  plan->apply( src.data, src.step, dst.data, dst.step );
+
+  this->releasePlan( key, plan );
+}
+
+int OpenCVFFTEngine::dstType( int srcType, int flags, bool inverse ) const
+{
+  // Same rules as cv::dft
+  if( !inverse && CV_MAT_CN( srcType ) == 1 && ( flags & cv::DFT_COMPLEX_OUTPUT ) )
+  {
+    return CV_MAKETYPE( CV_MAT_DEPTH( srcType ), 2 );
+  }
+  else if( inverse && CV_MAT_CN( srcType ) == 2 && ( flags & cv::DFT_REAL_OUTPUT ) )
+  {
+    return CV_MAKETYPE( CV_MAT_DEPTH( srcType ), 1 );
+  }
+
+  return srcType;
+}
+
+OpenCVFFTEngine::PlanKey OpenCVFFTEngine::planKey( const cv::Size & size, int srcType, int dstType, int flags, bool inverse ) const
+{
+  int halFlags = CV_HAL_DFT_IS_CONTINUOUS;
+
+  if( inverse )
+  {
+    halFlags |= CV_HAL_DFT_INVERSE;
+  }
+  if( flags & cv::DFT_SCALE )
+  {
+    halFlags |= CV_HAL_DFT_SCALE;
+  }
+
+  return PlanKey( size.height, size.width, CV_MAT_DEPTH( srcType ), CV_MAT_CN( srcType ), CV_MAT_CN( dstType ), halFlags );
+}
+
+cv::Ptr< cv::hal::DFT2D > OpenCVFFTEngine::acquirePlan( const PlanKey & key )
+{
+  {
+    std::lock_guard< std::mutex > lock( this->m_mutex );
+    std::vector< cv::Ptr< cv::hal::DFT2D > > & idle = this->m_plans[ key ];
+
+    if( !idle.empty() )
+    {
+      cv::Ptr< cv::hal::DFT2D > plan = idle.back();
+      idle.pop_back();
+
+      return plan;
+    }
+  }
+
+  return cv::hal::DFT2D::create(
+    std::get< 1 >( key ), std::get< 0 >( key ), std::get< 2 >( key ),
+    std::get< 3 >( key ), std::get< 4 >( key ), std::get< 5 >( key )
+  );
+}
+
+void OpenCVFFTEngine::releasePlan( const PlanKey & key, const cv::Ptr< cv::hal::DFT2D > & plan )
+{
+  std::lock_guard< std::mutex > lock( this->m_mutex );
+  this->m_plans[ key ].push_back( plan );
+}
+
+#else
+
+void OpenCVFFTEngine::dft( const cv::Mat & src, cv::Mat & dst, int flags )
+{
+  cv::dft( src, dst, flags );
+}
+
+void OpenCVFFTEngine::idft( const cv::Mat & src, cv::Mat & dst, int flags )
+{
+  cv::idft( src, dst, flags );
+}
+
+void OpenCVFFTEngine::prepare( const cv::Size & size, int type, int flags )
+{
+}
+
+#endif
@@ -0,0 +1,140 @@
+/*
+// License Agreement (3-clause BSD License)
+// Copyright (c) 2016, Jake Hall, Massimo Camplan, Sion Hannuna.
+// Third party copyrights and patents are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the names of the copyright holders nor the names of the contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall copyright holders or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+*/
+
+/*
+FFTEngine is the single entry point for the discrete Fourier transforms of the
+tracker. Implementations may cache plans (twiddle factors and work buffers) per
+transform size, so that the small 2D transforms performed every frame do not
+pay their setup cost on each call.
+
+OpenCVFFTEngine is the default implementation. On OpenCV 3.1 and newer it keeps
+a pool of cv::hal::DFT2D plans keyed by size, type and flags; on older versions
+it forwards to cv::dft and cv::idft.
+*/
+#ifndef _FFT_ENGINE_HPP_
+#define _FFT_ENGINE_HPP_
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/core/version.hpp>
+
+#if ( CV_VERSION_MAJOR > 3 ) || ( CV_VERSION_MAJOR == 3 && CV_VERSION_MINOR >= 1 )
+#include <opencv2/core/hal/hal.hpp>
+#define FFT_ENGINE_HAL_DFT
+#endif
+
+class FFTEngine
+{
+public:
+  virtual ~FFTEngine();
+
+  /**
+   * Forward transform with the semantics of cv::dft.
+   *
+   * @param src The real or complex input.
+   * @param dst The output. It is reallocated if its size or type do not match.
+   * @param flags The cv::DftFlags, e.g. 0 for a CCS packed result.
+   */
+  virtual void dft( const cv::Mat & src, cv::Mat & dst, int flags = 0 ) = 0;
+
+  /**
+   * Inverse transform with the semantics of cv::idft.
+   */
+  virtual void idft( const cv::Mat & src, cv::Mat & dst, int flags = 0 ) = 0;
+
+  /**
+   * Forward transforms a batch of equally sized channels in parallel.
+   * dst is resized to the number of channels in src.
+   */
+  virtual void dft( const std::vector< cv::Mat > & src, std::vector< cv::Mat > & dst, int flags = 0 );
+
+  /**
+   * Inverse transforms a batch of equally sized channels in parallel.
+   */
+  virtual void idft( const std::vector< cv::Mat > & src, std::vector< cv::Mat > & dst, int flags = 0 );
+
+  /**
+   * Prepares the engine for transforms of a given size, so that the first
+   * transform on the tracking path does not pay the setup cost.
+   *
+   * @param size The size of the transforms.
+   * @param type The type of the forward input, e.g. CV_64FC1.
+   * @param flags The flags of the forward transform; the matching inverse is prepared too.
+   */
+  virtual void prepare( const cv::Size & size, int type, int flags = 0 );
+
+  /**
+   * @returns The engine used by the tracker, an OpenCVFFTEngine unless replaced.
+   */
+  static std::shared_ptr< FFTEngine > getDefault();
+
+  /**
+   * Replaces the engine used by the tracker.
+   */
+  static void setDefault( const std::shared_ptr< FFTEngine > & engine );
+};
+
+class OpenCVFFTEngine : public FFTEngine
+{
+public:
+  using FFTEngine::dft;
+  using FFTEngine::idft;
+
+  virtual void dft( const cv::Mat & src, cv::Mat & dst, int flags = 0 );
+  virtual void idft( const cv::Mat & src, cv::Mat & dst, int flags = 0 );
+  virtual void prepare( const cv::Size & size, int type, int flags = 0 );
+
+#ifdef FFT_ENGINE_HAL_DFT
+private:
+  /** rows, cols, depth, source channels, destination channels, HAL flags */
+  typedef std::tuple< int, int, int, int, int, int > PlanKey;
+
+  void transform( const cv::Mat & src, cv::Mat & dst, int flags, bool inverse );
+  int dstType( int srcType, int flags, bool inverse ) const;
+  PlanKey planKey( const cv::Size & size, int srcType, int dstType, int flags, bool inverse ) const;
+  cv::Ptr< cv::hal::DFT2D > acquirePlan( const PlanKey & key );
+  void releasePlan( const PlanKey & key, const cv::Ptr< cv::hal::DFT2D > & plan );
+
+  /**
+   * The idle plans for each key. A plan holds work buffers and must not be
+   * applied by two threads at once, so it is taken out of the pool while in use.
+   */
+  std::map< PlanKey, std::vector< cv::Ptr< cv::hal::DFT2D > > > m_plans;
+  std::mutex m_mutex;
+#endif
+};
+
+#endif
@@ -0,0 +1,231 @@
+/*
+// License Agreement (3-clause BSD License)
+// Copyright (c) 2016, Jake Hall, Massimo Camplan, Sion Hannuna.
+// Third party copyrights and patents are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the names of the copyright holders nor the names of the contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall copyright holders or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+*/
+
+#include "ResponseAnalyser.hpp"
+#include "math_helper.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+  // Orders the heap such that its front holds the smallest of the kept values
+  bool greaterPeak( const ResponsePeak & a, const ResponsePeak & b )
+  {
+    return a.value > b.value;
+  }
+
+  // A local maximum has no greater 8-neighbour; of equal neighbours only the first in raster order is kept
+  template< typename T >
+  bool isLocalMaximum( const cv::Mat & response, int row, int col, bool circular )
+  {
+    const T value = response.ptr< T >( row )[ col ];
+
+    for( int dy = -1; dy <= 1; ++dy )
+    {
+      for( int dx = -1; dx <= 1; ++dx )
+      {
+        int y = row + dy;
+        int x = col + dx;
+
+        if( circular )
+        {
+          y = mod( y, response.rows );
+          x = mod( x, response.cols );
+        }
+        else if( y < 0 || y >= response.rows || x < 0 || x >= response.cols )
+        {
+          continue;
+        }
+
+        if( y == row && x == col )
+        {
+          continue;
+        }
+
+        const T neighbour = response.ptr< T >( y )[ x ];
+
+        if( neighbour > value || ( neighbour == value && ( y < row || ( y == row && x < col ) ) ) )
+        {
+          return false;
+        }
+      }
+    }
+
+    return true;
+  }
+}
+
+ResponseAnalyser::ResponseAnalyser( size_t maxPeaks, bool circular, int psrDeletionRange ) :
+  m_circular( circular ),
+  m_psrDeletionRange( psrDeletionRange )
+{
+  CV_Assert( psrDeletionRange >= 0 );
+
+  this->setMaxPeaks( maxPeaks );
+}
+
+void ResponseAnalyser::setMaxPeaks( size_t maxPeaks )
+{
+  CV_Assert( maxPeaks > 0 );
+
+  this->m_maxPeaks = maxPeaks;
+}
+
+size_t ResponseAnalyser::getMaxPeaks() const
+{
+  return this->m_maxPeaks;
+}
+
+void ResponseAnalyser::analyse( const cv::Mat & response, ResponseAnalysis & result ) const
+{
+  CV_Assert( response.type() == CV_32FC1 || response.type() == CV_64FC1 );
+  CV_Assert( !response.empty() );
+
+  if( response.depth() == CV_32F )
+  {
+    this->analyse< float >( response, result );
+  }
+  else
+  {
+    this->analyse< double >( response, result );
+  }
+}
+
+template< typename T >
+void ResponseAnalyser::analyse( const cv::Mat & response, ResponseAnalysis & result ) const
+{
+  const size_t maxPeaks = this->m_maxPeaks;
+  std::vector< ResponsePeak > & peaks = result.peaks;
+  double sum = 0.0;
+  double squaredSum = 0.0;
+  T threshold = -std::numeric_limits< T >::max();
+
+  peaks.clear();
+  peaks.reserve( maxPeaks );
+
+  for( int row = 0; row < response.rows; ++row )
+  {
+    const T * data = response.ptr< T >( row );
+
+    // Kept apart from the peak search, so that the compiler can vectorise it
+    for( int col = 0; col < response.cols; ++col )
+    {
+      const double v = std::max( static_cast< double >( data[ col ] ), 0.0 );
+      sum += v;
+      squaredSum += v * v;
+    }
+
+    for( int col = 0; col < response.cols; ++col )
+    {
+      if( data[ col ] <= threshold || !isLocalMaximum< T >( response, row, col, this->m_circular ) )
+      {
+        continue;
+      }
+
+      ResponsePeak peak = { cv::Point2i( col, row ), static_cast< double >( data[ col ] ) };
+
+      if( peaks.size() == maxPeaks )
+      {
+        std::pop_heap( peaks.begin(), peaks.end(), greaterPeak );
+        peaks.back() = peak;
+      }
+      else
+      {
+        peaks.push_back( peak );
+      }
+
+      std::push_heap( peaks.begin(), peaks.end(), greaterPeak );
+
+      if( peaks.size() == maxPeaks )
+      {
+        threshold = static_cast< T >( peaks.front().value );
+      }
+    }
+  }
+
+  // Only a response of NaNs has no peak
+  CV_Assert( !peaks.empty() );
+  std::sort_heap( peaks.begin(), peaks.end(), greaterPeak );
+
+  for( size_t i = 0; i < peaks.size(); ++i )
+  {
+    peaks[ i ].subPixelPosition = subPixelDelta< T >( response, peaks[ i ].position );
+  }
+
+  result.psr = this->sidelobeRatio< T >( response, peaks.front(), sum, squaredSum );
+}
+
+template< typename T >
+double ResponseAnalyser::sidelobeRatio( const cv::Mat & response, const ResponsePeak & max, double sum, double squaredSum ) const
+{
+  // Only the window around the maximum is visited again, to take its contribution out of the sums
+  const int range = this->m_psrDeletionRange;
+  cv::Range rows( max.position.y - range, max.position.y + range + 1 );
+  cv::Range cols( max.position.x - range, max.position.x + range + 1 );
+
+  if( this->m_circular )
+  {
+    // Every row and column at most once, however small the response
+    rows.end = rows.start + std::min( rows.size(), response.rows );
+    cols.end = cols.start + std::min( cols.size(), response.cols );
+  }
+  else
+  {
+    rows = cv::Range( std::max( rows.start, 0 ), std::min( rows.end, response.rows ) );
+    cols = cv::Range( std::max( cols.start, 0 ), std::min( cols.end, response.cols ) );
+  }
+
+  for( int y = rows.start; y < rows.end; ++y )
+  {
+    const T * data = response.ptr< T >( mod( y, response.rows ) );
+
+    for( int x = cols.start; x < cols.end; ++x )
+    {
+      const double v = std::max( static_cast< double >( data[ mod( x, response.cols ) ] ), 0.0 );
+      sum -= v;
+      squaredSum -= v * v;
+    }
+  }
+
+  const double n = static_cast< double >( response.total() ) - static_cast< double >( rows.size() ) * cols.size();
+
+  if( n <= 0.0 )
+  {
+    return 0.0;
+  }
+
+  const double mean = sum / n;
+  const double deviation = std::sqrt( std::max( squaredSum / n - mean * mean, 0.0 ) );
+
+  return ( max.value - mean ) / ( deviation + std::numeric_limits< T >::epsilon() );
+}
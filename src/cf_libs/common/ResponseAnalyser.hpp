@@ -0,0 +1,113 @@
+/*
+// License Agreement (3-clause BSD License)
+// Copyright (c) 2016, Jake Hall, Massimo Camplan, Sion Hannuna.
+// Third party copyrights and patents are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the names of the copyright holders nor the names of the contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall copyright holders or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+*/
+
+#ifndef _RESPONSEANALYSER_HPP_
+#define _RESPONSEANALYSER_HPP_
+
+#include <vector>
+#include <opencv2/core/core.hpp>
+
+/**
+ * A peak of a correlation response.
+ */
+struct ResponsePeak
+{
+  cv::Point2i position;
+  double value;
+
+  /** The position refined by fitting a parabola to its horizontal and vertical neighbours, see subPixelDelta */
+  cv::Point_< double > subPixelPosition;
+};
+
+/**
+ * The result of ResponseAnalyser::analyse. Kept by the caller between analyses, so that
+ * the buffer of the peaks is reused.
+ */
+struct ResponseAnalysis
+{
+  /** The highest local maxima in descending order, the first one is the maximum of the response */
+  std::vector< ResponsePeak > peaks;
+
+  /**
+   * The peak to sidelobe ratio (max - mean) / std, where the sidelobe is the response outside the
+   * window around the maximum with negative values treated as zero, see ResponseAnalyser
+   */
+  double psr = 0.0;
+};
+
+/**
+ * Extracts the K highest local maxima of a correlation response and its peak to sidelobe
+ * ratio in a single pass.
+ *
+ * A value is only a peak if none of its 8 neighbours is greater, so the peaks do not
+ * cluster around the maximum. The top K values are kept in a bounded heap and the sum and the sum of squares of the
+ * clamped response are accumulated alongside, so the cost is linear in the size of the
+ * response and no per pixel state is stored; only the window around the maximum is
+ * visited again to take it out of the sidelobe. The analyser only holds its configuration,
+ * so one instance can analyse several responses concurrently.
+ *
+ *  [1] D. Bolme, et al., Visual Object Tracking using Adaptive Correlation Filters, CVPR 2010
+ */
+class ResponseAnalyser
+{
+public:
+  /**
+   * @param maxPeaks The number of highest values to extract from every response.
+   * @param circular Whether the neighbours and the window around the maximum wrap around
+   *   the borders, as in the response of a circular correlation.
+   * @param psrDeletionRange The half size of the window around the maximum which is
+   *   excluded from the sidelobe.
+   */
+  explicit ResponseAnalyser( size_t maxPeaks = 1, bool circular = true, int psrDeletionRange = 5 );
+
+  void setMaxPeaks( size_t maxPeaks );
+  size_t getMaxPeaks() const;
+
+  /**
+   * Analyses a single channel CV_32F or CV_64F response.
+   *
+   * @param[out] result The peaks and the peak to sidelobe ratio of the response. Its buffers
+   *   are reused, so an analysis kept across calls does not allocate once it has grown.
+   */
+  void analyse( const cv::Mat & response, ResponseAnalysis & result ) const;
+private:
+  size_t m_maxPeaks;
+  bool m_circular;
+  int m_psrDeletionRange;
+
+  template< typename T >
+  void analyse( const cv::Mat & response, ResponseAnalysis & result ) const;
+
+  template< typename T >
+  double sidelobeRatio( const cv::Mat & response, const ResponsePeak & max, double sum, double squaredSum ) const;
+};
+
+#endif
@@ -1,8 +1,23 @@
 #ifndef _TYPEDEFS_HPP_
 #define _TYPEDEFS_HPP_
 
+#include <opencv2/core/core.hpp>
+
 typedef cv::Rect_< double > Rect;
 typedef cv::Point_< double > Point;
 typedef cv::Size_< double > Size;
 
+/**
+ * Real is the scalar type of the features, spectra and filter model.
+ * It is selected at build time with the DSKCF_SINGLE_PRECISION option.
+ */
+#ifdef DSKCF_SINGLE_PRECISION
+typedef float Real;
+#else
+typedef double Real;
+#endif
+
+typedef cv::Mat_< Real > Mat1r;
+typedef cv::Mat_< cv::Vec< Real, 2 > > Mat2r;
+
 #endif
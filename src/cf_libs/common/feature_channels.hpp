@@ -38,26 +38,185 @@
 #define FHOG_FEATURE_CHANNELS_H_
 
 #include "opencv2/core/core.hpp"
+#include "opencv2/imgproc/imgproc.hpp"
 #include "math_helper.hpp"
+#include "FFTEngine.hpp"
+#include "spectrum_ops.hpp"
+#include "Typedefs.hpp"
 #include <memory>
 #include <array>
 #include <vector>
 
-#include <tbb/parallel_for_each.h>
-#include <tbb/parallel_for.h>
-
+#include "ExecutionPolicy.hpp"
+#include <tbb/blocked_range.h>
+
+/**
+ * FeatureChannels_ holds the channels of a feature map or of its spectrum.
+ *
+ * The channels may be stored in one contiguous tensor (channels x rows x cols,
+ * planar, every plane aligned to TENSOR_ALIGNMENT bytes), in which case each
+ * entry of channels is a cv::Mat view on its plane. Element-wise operations then
+ * run over the whole tensor at once instead of dispatching per channel. Channels
+ * assigned individually are still supported; operations fall back to a per
+ * channel loop whenever the tensor layout does not hold.
+ */
 class FeatureChannels_
 {
 public:
   FeatureChannels_( const size_t channelCount = 31 )
   {
     this->channels.resize( channelCount );
+    this->m_planeStride = 0;
   }
 
   virtual ~FeatureChannels_()
   {
   }
 
+  /**
+   * Allocates all channels in one contiguous tensor and makes every channel a view on its plane.
+   * The content of the channels is undefined afterwards.
+   *
+   * @param size The size of every channel.
+   * @param type The type of every channel, e.g. CV_64FC1 for features or CCS spectra.
+   */
+  void allocate( const cv::Size & size, int type )
+  {
+    const size_t elemSize = CV_ELEM_SIZE( type );
+    const size_t planeBytes = cv::alignSize( static_cast< size_t >( size.area() ) * elemSize, TENSOR_ALIGNMENT );
+
+    this->m_planeStride = planeBytes / elemSize;
+
+    const int length = static_cast< int >( this->m_planeStride * this->numberOfChannels() );
+
+    // Over-allocate by one alignment unit and start the tensor at the first aligned element, as
+    // cv::Mat only guarantees the alignment of its own allocator; the view keeps the buffer alive
+    cv::Mat buffer( 1, length + static_cast< int >( TENSOR_ALIGNMENT / elemSize ), type );
+    const int offset = static_cast< int >( ( cv::alignPtr( buffer.data, TENSOR_ALIGNMENT ) - buffer.data ) / elemSize );
+    this->m_tensor = buffer.colRange( offset, offset + length );
+
+    for( size_t c = 0; c < this->numberOfChannels(); ++c )
+    {
+      const int begin = static_cast< int >( c * this->m_planeStride );
+      cv::Mat plane = this->m_tensor.colRange( begin, static_cast< int >( begin + this->m_planeStride ) );
+
+      // Keep the alignment padding finite, as the tensor wide operations also touch it
+      plane.colRange( size.area(), plane.cols ).setTo( 0 );
+      this->channels[ c ] = plane.colRange( 0, size.area() ).reshape( 0, size.height );
+    }
+  }
+
+  /**
+   * @returns True if every channel is still the view on its plane of the tensor.
+   */
+  bool isContiguous() const
+  {
+    if( this->m_tensor.empty() || this->channels.empty() )
+    {
+      return false;
+    }
+
+    const size_t planeBytes = this->m_planeStride * this->m_tensor.elemSize();
+    const cv::Size size = this->channels[ 0 ].size();
+
+    for( size_t c = 0; c < this->numberOfChannels(); ++c )
+    {
+      const cv::Mat & channel = this->channels[ c ];
+
+      if( channel.data != this->m_tensor.data + c * planeBytes || channel.size() != size ||
+          channel.type() != this->m_tensor.type() || !channel.isContinuous() )
+      {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  /**
+   * Copies the channels into a new tensor, unless they are already contiguous.
+   * All channels must have the same size and type.
+   */
+  void makeContiguous()
+  {
+    if( this->isContiguous() )
+    {
+      return;
+    }
+
+    std::vector< cv::Mat > source = this->channels;
+    this->allocate( source[ 0 ].size(), source[ 0 ].type() );
+
+    for( size_t c = 0; c < source.size(); ++c )
+    {
+      CV_Assert( source[ c ].size() == this->channels[ c ].size() && source[ c ].type() == this->channels[ c ].type() );
+      source[ c ].copyTo( this->channels[ c ] );
+    }
+  }
+
+  /**
+   * @returns A deep copy of the channels, stored as a contiguous tensor.
+   */
+  std::shared_ptr< FeatureChannels_ > clone() const
+  {
+    auto result = std::make_shared< FeatureChannels_ >( this->numberOfChannels() );
+
+    if( this->numberOfChannels() == 0 || this->channels[ 0 ].empty() )
+    {
+      return result;
+    }
+
+    result->allocate( this->channels[ 0 ].size(), this->channels[ 0 ].type() );
+
+    if( this->isContiguous() )
+    {
+      this->m_tensor.copyTo( result->m_tensor );
+    }
+    else
+    {
+      for( size_t c = 0; c < this->numberOfChannels(); ++c )
+      {
+        this->channels[ c ].copyTo( result->channels[ c ] );
+      }
+    }
+
+    return result;
+  }
+
+  /**
+   * @returns A 1 x ( channels * plane stride ) view on the whole tensor, or an empty Mat if
+   *   the channels are not contiguous.
+   */
+  cv::Mat tensor() const
+  {
+    return this->isContiguous() ? this->m_tensor : cv::Mat();
+  }
+
+  /**
+   * @returns The channels interleaved into a single rows x cols Mat with one Mat channel per
+   *   feature channel, e.g. for per-pixel descriptors.
+   */
+  cv::Mat toInterleaved() const
+  {
+    cv::Mat result;
+    cv::merge( this->channels, result );
+
+    return result;
+  }
+
+  /**
+   * Replaces the channels with the planes of an interleaved Mat, stored as a contiguous tensor.
+   */
+  void fromInterleaved( const cv::Mat & interleaved )
+  {
+    this->channels.resize( interleaved.channels() );
+    this->allocate( interleaved.size(), CV_MAKETYPE( interleaved.depth(), 1 ) );
+    cv::split( interleaved, this->channels );
+  }
+
+  /**
+   * @returns The channels of left followed by those of right. The channel matrices are shared, not copied.
+   */
   static std::shared_ptr< FeatureChannels_ > concatFeatures( const std::shared_ptr< FeatureChannels_ > & left, const std::shared_ptr< FeatureChannels_ > & right )
   {
     CV_Assert( left->numberOfChannels() == right->numberOfChannels() );
@@ -71,10 +230,25 @@ public:
 
   static void mulValueFeatures(std::shared_ptr<FeatureChannels_>& m, const double & value)
   {
-    tbb::parallel_for_each( m->channels.begin(), m->channels.end(),
-      [value]( cv::Mat & m_ ) -> void
+    cv::Mat tensor = m->tensor();
+
+    if( !tensor.empty() )
+    {
+      parallelForBlocks( 0, tensor.cols, ExecutionPolicy::current().tensorGrain,
+        [&tensor, value]( const tbb::blocked_range< int > & range ) -> void
+        {
+          cv::Mat block = tensor.colRange( range.begin(), range.end() );
+          block *= value;
+        }
+      );
+
+      return;
+    }
+
+    parallelFor< size_t >( 0, m->numberOfChannels(),
+      [&m, value]( size_t index ) -> void
         {
-        m_ *= value;
+        m->channels[ index ] *= value;
         }
     );
   }
@@ -83,7 +257,23 @@ public:
   {
     CV_Assert( A->numberOfChannels() == B->numberOfChannels() );
 
-    tbb::parallel_for< size_t >( 0, A->numberOfChannels(), 1,
+    cv::Mat tensorA = A->tensor();
+    cv::Mat tensorB = B->tensor();
+
+    if( !tensorA.empty() && !tensorB.empty() && tensorA.size() == tensorB.size() && tensorA.type() == tensorB.type() )
+    {
+      parallelForBlocks( 0, tensorA.cols, ExecutionPolicy::current().tensorGrain,
+        [&tensorA, &tensorB]( const tbb::blocked_range< int > & range ) -> void
+        {
+          cv::Mat block = tensorA.colRange( range.begin(), range.end() );
+          block += tensorB.colRange( range.begin(), range.end() );
+        }
+      );
+
+      return;
+    }
+
+    parallelFor< size_t >( 0, A->numberOfChannels(),
       [&A, &B]( size_t index ) -> void
       {
         A->channels[ index ] += B->channels[ index ];
@@ -91,6 +281,37 @@ public:
     );
   }
 
+  /**
+   * A = ( 1 - t ) * A + t * B, in place, so that the channels of A stay views on its tensor.
+   */
+  static void lerpFeatures(std::shared_ptr<FeatureChannels_>& A, const std::shared_ptr<FeatureChannels_>& B, const double t)
+  {
+    CV_Assert( A->numberOfChannels() == B->numberOfChannels() );
+
+    cv::Mat tensorA = A->tensor();
+    cv::Mat tensorB = B->tensor();
+
+    if( !tensorA.empty() && !tensorB.empty() && tensorA.size() == tensorB.size() && tensorA.type() == tensorB.type() )
+    {
+      parallelForBlocks( 0, tensorA.cols, ExecutionPolicy::current().tensorGrain,
+        [&tensorA, &tensorB, t]( const tbb::blocked_range< int > & range ) -> void
+        {
+          cv::Mat block = tensorA.colRange( range.begin(), range.end() );
+          lerpInPlace( block, tensorB.colRange( range.begin(), range.end() ), t );
+        }
+      );
+
+      return;
+    }
+
+    parallelFor< size_t >( 0, A->numberOfChannels(),
+      [&A, &B, t]( size_t index ) -> void
+      {
+        lerpInPlace( A->channels[ index ], B->channels[ index ], t );
+      }
+    );
+  }
+
   static cv::Mat sumFeatures(const std::shared_ptr<FeatureChannels_>& x)
   {
     cv::Mat result = x->channels[0].clone();
@@ -103,38 +324,79 @@ public:
     return result;
   }
 
+  /**
+   * Multiplies every channel element-wise with m, in place: the channels keep their storage, so
+   * every feature set sharing these channel matrices (see concatFeatures) sees the product too.
+   * Clone the features first if they are still used unmultiplied.
+   */
   static void mulFeatures(std::shared_ptr<FeatureChannels_>& features, const cv::Mat& m)
   {
-    tbb::parallel_for_each( features->channels.begin(), features->channels.end(),
-      [&m]( cv::Mat & channel ) -> void
+    parallelFor< size_t >( 0, features->numberOfChannels(),
+      [&features, &m]( size_t index ) -> void
       {
-        channel = channel.mul( m );
+        cv::multiply( features->channels[ index ], m, features->channels[ index ] );
       }
     );
   }
 
-  static std::shared_ptr<FeatureChannels_> dftFeatures( const std::shared_ptr<FeatureChannels_>& features, int flags = 0)
+  /**
+   * Resamples a region of every channel to a new grid size with bilinear interpolation.
+   *
+   * @returns The resampled channels, in a new tensor.
+   */
+  static std::shared_ptr<FeatureChannels_> resizeFeatures( const std::shared_ptr<FeatureChannels_>& features, const cv::Rect & roi, const cv::Size & size )
   {
     auto result = std::make_shared<FeatureChannels_>( features->numberOfChannels() );
+    result->allocate( size, features->channels[ 0 ].type() );
 
-    tbb::parallel_for< size_t >( 0, result->numberOfChannels(), 1,
-      [&features,&result,&flags]( size_t index ) -> void
+    parallelFor< size_t >( 0, features->numberOfChannels(),
+      [&features, &result, &roi, &size]( size_t index ) -> void
       {
-        cv::dft( features->channels[ index ], result->channels[ index ], flags );
+        // The destination already has the right size and type, so resize writes into the tensor
+        cv::resize( features->channels[ index ]( roi ), result->channels[ index ], size, 0.0, 0.0, cv::INTER_LINEAR );
       }
     );
 
     return result;
   }
 
+  static std::shared_ptr<FeatureChannels_> dftFeatures( const std::shared_ptr<FeatureChannels_>& features, int flags = 0)
+  {
+    auto result = std::make_shared<FeatureChannels_>( features->numberOfChannels() );
+    const cv::Mat & first = features->channels[ 0 ];
+    const bool complexOutput = ( flags & cv::DFT_COMPLEX_OUTPUT ) && first.channels() == 1;
+
+    result->allocate( first.size(), complexOutput ? CV_MAKETYPE( first.depth(), 2 ) : first.type() );
+    FFTEngine::getDefault()->dft( features->channels, result->channels, flags );
+
+    return result;
+  }
+
   static std::shared_ptr<FeatureChannels_> idftFeatures( const std::shared_ptr<FeatureChannels_>& features)
   {
     auto result = std::make_shared<FeatureChannels_>( features->numberOfChannels() );
+    const cv::Mat & first = features->channels[ 0 ];
+
+    result->allocate( first.size(), CV_MAKETYPE( first.depth(), 1 ) );
+    FFTEngine::getDefault()->idft( features->channels, result->channels, cv::DFT_REAL_OUTPUT | cv::DFT_SCALE );
 
-    tbb::parallel_for< size_t >( 0, result->numberOfChannels(), 1,
-      [&features,&result]( size_t index ) -> void
+    return result;
+  }
+
+  /**
+   * Shifts every CCS packed channel in the Fourier domain, see shiftSpectrumCcs.
+   *
+   * @returns The spectra of the channels cyclically shifted by shift cells, in a new tensor.
+   */
+  static std::shared_ptr<FeatureChannels_> shiftSpectrumFeatures( const std::shared_ptr<FeatureChannels_>& features, const cv::Point2d & shift )
+  {
+    auto result = std::make_shared<FeatureChannels_>( features->numberOfChannels() );
+    result->allocate( features->channels[ 0 ].size(), features->channels[ 0 ].type() );
+
+    parallelFor< size_t >( 0, features->numberOfChannels(),
+      [&features, &result, &shift]( size_t index ) -> void
       {
-        cv::idft( features->channels[ index ], result->channels[ index ], cv::DFT_REAL_OUTPUT | cv::DFT_SCALE );
+        shiftSpectrumCcs( features->channels[ index ], result->channels[ index ], shift );
       }
     );
 
@@ -156,16 +418,73 @@ public:
     return sum_ / n;
   }
 
+  static double squaredNormFeaturesCcs(const std::shared_ptr<FeatureChannels_>& Af)
+  {
+    // Re(a*conj(a)) = Re(a)^2 + Im(a)^2
+    int n = Af->channels[0].rows * Af->channels[0].cols;
+    double sum_ = 0;
+
+    for (size_t i = 0; i < Af->numberOfChannels(); ++i)
+    {
+      sum_ += squaredNormCcs(Af->channels[i]);
+    }
+
+    return sum_ / n;
+  }
+
   static std::shared_ptr<FeatureChannels_> mulSpectrumsFeatures( const std::shared_ptr<FeatureChannels_>& Af, const std::shared_ptr<FeatureChannels_>& Bf, bool conjBf)
   {
     CV_Assert( Af->numberOfChannels() == Bf->numberOfChannels() );
 
     auto result = std::make_shared<FeatureChannels_>( Af->numberOfChannels() );
 
-    tbb::parallel_for< size_t >( 0, Af->numberOfChannels(), 1,
+    parallelFor< size_t >( 0, Af->numberOfChannels(),
       [&Af, &Bf, &result, conjBf]( size_t index ) -> void
       {
-        mulSpectrums( Af->channels[ index ], Bf->channels[ index ], result->channels[ index ], 0, conjBf );
+        if( Af->channels[ index ].channels() == 1 )
+        {
+          mulSpectrumsCcs( Af->channels[ index ], Bf->channels[ index ], result->channels[ index ], conjBf );
+        }
+        else
+        {
+          mulSpectrums( Af->channels[ index ], Bf->channels[ index ], result->channels[ index ], 0, conjBf );
+        }
+      }
+    );
+
+    return result;
+  }
+
+  /**
+   * Multiplies the spectra of every pair of channels and sums the products over all channels.
+   * The DFT is linear, so the inverse DFT of the result equals the sum of the inverse DFTs of
+   * the per channel products, at the cost of a single inverse DFT.
+   *
+   * @param Af The first collection of spectra, either CCS packed or complex.
+   * @param Bf The second collection of spectra, in the same format as Af.
+   * @param conjBf If true, the spectra of Bf are conjugated before the multiplication.
+   *
+   * @returns A single spectrum, in the format of the inputs, holding the sum of the products.
+   */
+  static cv::Mat mulSpectrumsSumFeatures( const std::shared_ptr<FeatureChannels_>& Af, const std::shared_ptr<FeatureChannels_>& Bf, bool conjBf )
+  {
+    CV_Assert( Af->numberOfChannels() == Bf->numberOfChannels() );
+    CV_Assert( Af->channels[ 0 ].type() == Bf->channels[ 0 ].type() );
+
+    const cv::Mat & first = Af->channels[ 0 ];
+    cv::Mat result = cv::Mat::zeros( first.rows, first.cols, first.type() );
+
+    parallelForBlocks( 0, first.rows, 0,
+      [&Af, &Bf, &result, conjBf]( const tbb::blocked_range< int > & rows ) -> void
+      {
+        if( result.depth() == CV_32F )
+        {
+          mulSpectrumsAccumulateRows< float >( Af, Bf, result, rows, conjBf );
+        }
+        else
+        {
+          mulSpectrumsAccumulateRows< double >( Af, Bf, result, rows, conjBf );
+        }
       }
     );
 
@@ -178,6 +497,54 @@ public:
   }
 
   std::vector< cv::Mat > channels;
+
+  /** The alignment of every plane of the tensor in bytes */
+  static const size_t TENSOR_ALIGNMENT = 64;
+
+private:
+  /** The 1 x ( channels * m_planeStride ) buffer holding all channels, if allocated */
+  cv::Mat m_tensor;
+
+  /** The distance between two planes of the tensor, in elements */
+  size_t m_planeStride;
+
+  template< typename T >
+  static void mulSpectrumsAccumulateRows( const std::shared_ptr<FeatureChannels_>& Af, const std::shared_ptr<FeatureChannels_>& Bf,
+    cv::Mat & result, const tbb::blocked_range< int > & rows, bool conjBf )
+  {
+    if( result.channels() == 1 )
+    {
+      for( size_t channel = 0; channel < Af->numberOfChannels(); ++channel )
+      {
+        mulAddSpectrumsCcs( Af->channels[ channel ], Bf->channels[ channel ], result, conjBf, cv::Range( rows.begin(), rows.end() ) );
+      }
+
+      return;
+    }
+
+    // (a,b) * (c,d) = (ac-bd, ad+bc) and (a,b) * conj(c,d) = (ac+bd, bc-ad)
+    const int width = result.cols * 2;
+    const T sign = conjBf ? static_cast< T >( -1 ) : static_cast< T >( 1 );
+
+    for( int row = rows.begin(); row < rows.end(); ++row )
+    {
+      T* dst = result.ptr< T >( row );
+
+      for( size_t channel = 0; channel < Af->numberOfChannels(); ++channel )
+      {
+        const T* a = Af->channels[ channel ].ptr< T >( row );
+        const T* b = Bf->channels[ channel ].ptr< T >( row );
+
+        for( int col = 0; col < width; col += 2 )
+        {
+          const T d = sign * b[ col + 1 ];
+
+          dst[ col ]     += a[ col ] * b[ col ] - a[ col + 1 ] * d;
+          dst[ col + 1 ] += a[ col ] * d + a[ col + 1 ] * b[ col ];
+        }
+      }
+    }
+  }
 };
 
 typedef FeatureChannels_ FC;
@@ -236,6 +236,41 @@ void visualiseHistogram( const std::string & windowName, const cv::Mat1f & histo
   }
 }
 
+// dftCost estimates the relative cost of a 2D DFT of the given size.
+// A mixed radix FFT of length n costs about n times the sum of the
+// prime factors of n, so sizes with large prime factors are penalised.
+//
+// @param size  : The size of the transform
+//
+// @returns     : The estimated number of operations, up to a constant
+double dftCost( const cv::Size2i & size )
+{
+  const auto primeFactorSum = []( int n ) -> double
+  {
+    double sum = 0.0;
+
+    for( int factor = 2; factor * factor <= n; ++factor )
+    {
+      while( n % factor == 0 )
+      {
+        sum += factor;
+        n /= factor;
+      }
+    }
+
+    if( n > 1 )
+    {
+      sum += n;
+    }
+
+    return sum;
+  };
+
+  const double area = static_cast< double >( size.area() );
+
+  return area * ( primeFactorSum( size.width ) + primeFactorSum( size.height ) );
+}
+
 // modelNoise is a function for calculating the depth noise for a
 // given distance according to the quadratic noise model presented in [1]
 //
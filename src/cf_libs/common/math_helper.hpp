@@ -78,6 +78,7 @@ void visualise( const std::string windowName, const cv::Mat3b & image );
 void visualise( const std::string windowName, const cv::Mat1w & image );
 void visualise( const std::string windowName, const cv::Mat1d & image );
 double modelNoise( const double depth, const double std );
+double dftCost( const cv::Size2i & size );
 
 template< class T, class U >
 const cv::Point_< T > pointCast( const cv::Point_< U > & a )
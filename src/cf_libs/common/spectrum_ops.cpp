@@ -0,0 +1,815 @@
+/*
+// License Agreement (3-clause BSD License)
+// Copyright (c) 2016, Jake Hall, Massimo Camplan, Sion Hannuna.
+// Third party copyrights and patents are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the names of the copyright holders nor the names of the contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall copyright holders or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+*/
+
+#include "spectrum_ops.hpp"
+
+#include <algorithm>
+#include <complex>
+#include <vector>
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define SPECTRUM_OPS_SSE2
+#include <immintrin.h>
+
+#if defined( __GNUC__ )
+#define SPECTRUM_OPS_AVX2 __attribute__(( target( "avx2" ) ))
+#else
+#define SPECTRUM_OPS_AVX2
+#endif
+#endif
+
+namespace
+{
+  // Kernels on raw rows. Complex kernels work on 'pairs' interleaved ( re, im ) numbers:
+  // (a,b) * (c,d) = (ac-bd, ad+bc), (a,b) * conj(c,d) = (ac+bd, bc-ad)
+  // (a,b) / (c,d) = (a,b) * conj(c,d) / (c^2 + d^2)
+  template< typename T >
+  struct Kernels
+  {
+    void ( *complexMul )( const T * a, const T * b, T * dst, int pairs, bool conjB, bool accumulate );
+    void ( *complexDiv )( const T * a, const T * b, T * dst, int pairs );
+    void ( *lerp )( T * dst, const T * src, int n, T t );
+    double ( *sumSquares )( const T * a, int n );
+  };
+
+  template< typename T >
+  void complexMulScalar( const T * a, const T * b, T * dst, int pairs, bool conjB, bool accumulate )
+  {
+    const T sign = conjB ? T( -1 ) : T( 1 );
+
+    for( int i = 0; i < 2 * pairs; i += 2 )
+    {
+      const T d = sign * b[ i + 1 ];
+      const T re = a[ i ] * b[ i ] - a[ i + 1 ] * d;
+      const T im = a[ i ] * d + a[ i + 1 ] * b[ i ];
+
+      dst[ i ] = accumulate ? dst[ i ] + re : re;
+      dst[ i + 1 ] = accumulate ? dst[ i + 1 ] + im : im;
+    }
+  }
+
+  template< typename T >
+  void complexDivScalar( const T * a, const T * b, T * dst, int pairs )
+  {
+    for( int i = 0; i < 2 * pairs; i += 2 )
+    {
+      const T v = T( 1 ) / ( b[ i ] * b[ i ] + b[ i + 1 ] * b[ i + 1 ] );
+      const T re = ( a[ i ] * b[ i ] + a[ i + 1 ] * b[ i + 1 ] ) * v;
+      const T im = ( a[ i + 1 ] * b[ i ] - a[ i ] * b[ i + 1 ] ) * v;
+
+      dst[ i ] = re;
+      dst[ i + 1 ] = im;
+    }
+  }
+
+  template< typename T >
+  void lerpScalar( T * dst, const T * src, int n, T t )
+  {
+    const T s = T( 1 ) - t;
+
+    for( int i = 0; i < n; ++i )
+    {
+      dst[ i ] = s * dst[ i ] + t * src[ i ];
+    }
+  }
+
+  template< typename T >
+  double sumSquaresScalar( const T * a, int n )
+  {
+    double sum = 0.0;
+
+    for( int i = 0; i < n; ++i )
+    {
+      sum += static_cast< double >( a[ i ] ) * static_cast< double >( a[ i ] );
+    }
+
+    return sum;
+  }
+
+#ifdef SPECTRUM_OPS_SSE2
+  // SSE2: one complex double or two complex floats per register
+
+  void complexMulSse2( const double * a, const double * b, double * dst, int pairs, bool conjB, bool accumulate )
+  {
+    const __m128d sign = conjB ? _mm_set_pd( -1.0, 1.0 ) : _mm_set_pd( 1.0, -1.0 );
+
+    for( int i = 0; i < pairs; ++i )
+    {
+      const __m128d va = _mm_loadu_pd( a + 2 * i );
+      const __m128d vb = _mm_loadu_pd( b + 2 * i );
+      const __m128d re = _mm_unpacklo_pd( vb, vb );
+      const __m128d im = _mm_unpackhi_pd( vb, vb );
+      const __m128d swapped = _mm_shuffle_pd( va, va, 1 );
+      __m128d r = _mm_add_pd( _mm_mul_pd( va, re ), _mm_mul_pd( _mm_mul_pd( swapped, im ), sign ) );
+
+      if( accumulate )
+      {
+        r = _mm_add_pd( r, _mm_loadu_pd( dst + 2 * i ) );
+      }
+
+      _mm_storeu_pd( dst + 2 * i, r );
+    }
+  }
+
+  void complexMulSse2( const float * a, const float * b, float * dst, int pairs, bool conjB, bool accumulate )
+  {
+    const __m128 sign = conjB ? _mm_set_ps( -1.0f, 1.0f, -1.0f, 1.0f ) : _mm_set_ps( 1.0f, -1.0f, 1.0f, -1.0f );
+    int i = 0;
+
+    for( ; i + 2 <= pairs; i += 2 )
+    {
+      const __m128 va = _mm_loadu_ps( a + 2 * i );
+      const __m128 vb = _mm_loadu_ps( b + 2 * i );
+      const __m128 re = _mm_shuffle_ps( vb, vb, _MM_SHUFFLE( 2, 2, 0, 0 ) );
+      const __m128 im = _mm_shuffle_ps( vb, vb, _MM_SHUFFLE( 3, 3, 1, 1 ) );
+      const __m128 swapped = _mm_shuffle_ps( va, va, _MM_SHUFFLE( 2, 3, 0, 1 ) );
+      __m128 r = _mm_add_ps( _mm_mul_ps( va, re ), _mm_mul_ps( _mm_mul_ps( swapped, im ), sign ) );
+
+      if( accumulate )
+      {
+        r = _mm_add_ps( r, _mm_loadu_ps( dst + 2 * i ) );
+      }
+
+      _mm_storeu_ps( dst + 2 * i, r );
+    }
+
+    complexMulScalar< float >( a + 2 * i, b + 2 * i, dst + 2 * i, pairs - i, conjB, accumulate );
+  }
+
+  void complexDivSse2( const double * a, const double * b, double * dst, int pairs )
+  {
+    const __m128d sign = _mm_set_pd( -1.0, 1.0 );
+
+    for( int i = 0; i < pairs; ++i )
+    {
+      const __m128d va = _mm_loadu_pd( a + 2 * i );
+      const __m128d vb = _mm_loadu_pd( b + 2 * i );
+      const __m128d re = _mm_unpacklo_pd( vb, vb );
+      const __m128d im = _mm_unpackhi_pd( vb, vb );
+      const __m128d swapped = _mm_shuffle_pd( va, va, 1 );
+      const __m128d numerator = _mm_add_pd( _mm_mul_pd( va, re ), _mm_mul_pd( _mm_mul_pd( swapped, im ), sign ) );
+      const __m128d squared = _mm_mul_pd( vb, vb );
+      const __m128d denominator = _mm_add_pd( squared, _mm_shuffle_pd( squared, squared, 1 ) );
+
+      _mm_storeu_pd( dst + 2 * i, _mm_div_pd( numerator, denominator ) );
+    }
+  }
+
+  void complexDivSse2( const float * a, const float * b, float * dst, int pairs )
+  {
+    const __m128 sign = _mm_set_ps( -1.0f, 1.0f, -1.0f, 1.0f );
+    int i = 0;
+
+    for( ; i + 2 <= pairs; i += 2 )
+    {
+      const __m128 va = _mm_loadu_ps( a + 2 * i );
+      const __m128 vb = _mm_loadu_ps( b + 2 * i );
+      const __m128 re = _mm_shuffle_ps( vb, vb, _MM_SHUFFLE( 2, 2, 0, 0 ) );
+      const __m128 im = _mm_shuffle_ps( vb, vb, _MM_SHUFFLE( 3, 3, 1, 1 ) );
+      const __m128 swapped = _mm_shuffle_ps( va, va, _MM_SHUFFLE( 2, 3, 0, 1 ) );
+      const __m128 numerator = _mm_add_ps( _mm_mul_ps( va, re ), _mm_mul_ps( _mm_mul_ps( swapped, im ), sign ) );
+      const __m128 squared = _mm_mul_ps( vb, vb );
+      const __m128 denominator = _mm_add_ps( squared, _mm_shuffle_ps( squared, squared, _MM_SHUFFLE( 2, 3, 0, 1 ) ) );
+
+      _mm_storeu_ps( dst + 2 * i, _mm_div_ps( numerator, denominator ) );
+    }
+
+    complexDivScalar< float >( a + 2 * i, b + 2 * i, dst + 2 * i, pairs - i );
+  }
+
+  void lerpSse2( double * dst, const double * src, int n, double t )
+  {
+    const __m128d vs = _mm_set1_pd( 1.0 - t );
+    const __m128d vt = _mm_set1_pd( t );
+    int i = 0;
+
+    for( ; i + 2 <= n; i += 2 )
+    {
+      _mm_storeu_pd( dst + i, _mm_add_pd( _mm_mul_pd( vs, _mm_loadu_pd( dst + i ) ), _mm_mul_pd( vt, _mm_loadu_pd( src + i ) ) ) );
+    }
+
+    lerpScalar< double >( dst + i, src + i, n - i, t );
+  }
+
+  void lerpSse2( float * dst, const float * src, int n, float t )
+  {
+    const __m128 vs = _mm_set1_ps( 1.0f - t );
+    const __m128 vt = _mm_set1_ps( t );
+    int i = 0;
+
+    for( ; i + 4 <= n; i += 4 )
+    {
+      _mm_storeu_ps( dst + i, _mm_add_ps( _mm_mul_ps( vs, _mm_loadu_ps( dst + i ) ), _mm_mul_ps( vt, _mm_loadu_ps( src + i ) ) ) );
+    }
+
+    lerpScalar< float >( dst + i, src + i, n - i, t );
+  }
+
+  double sumSquaresSse2( const double * a, int n )
+  {
+    __m128d sum = _mm_setzero_pd();
+    int i = 0;
+
+    for( ; i + 2 <= n; i += 2 )
+    {
+      const __m128d v = _mm_loadu_pd( a + i );
+      sum = _mm_add_pd( sum, _mm_mul_pd( v, v ) );
+    }
+
+    double lanes[ 2 ];
+    _mm_storeu_pd( lanes, sum );
+
+    return lanes[ 0 ] + lanes[ 1 ] + sumSquaresScalar< double >( a + i, n - i );
+  }
+
+  double sumSquaresSse2( const float * a, int n )
+  {
+    __m128d sum = _mm_setzero_pd();
+    int i = 0;
+
+    for( ; i + 4 <= n; i += 4 )
+    {
+      const __m128 v = _mm_loadu_ps( a + i );
+      const __m128d low = _mm_cvtps_pd( v );
+      const __m128d high = _mm_cvtps_pd( _mm_movehl_ps( v, v ) );
+      sum = _mm_add_pd( sum, _mm_add_pd( _mm_mul_pd( low, low ), _mm_mul_pd( high, high ) ) );
+    }
+
+    double lanes[ 2 ];
+    _mm_storeu_pd( lanes, sum );
+
+    return lanes[ 0 ] + lanes[ 1 ] + sumSquaresScalar< float >( a + i, n - i );
+  }
+
+  // AVX2: two complex doubles or four complex floats per register
+
+  SPECTRUM_OPS_AVX2 void complexMulAvx2( const double * a, const double * b, double * dst, int pairs, bool conjB, bool accumulate )
+  {
+    const __m256d sign = conjB ? _mm256_set_pd( -1.0, 1.0, -1.0, 1.0 ) : _mm256_set_pd( 1.0, -1.0, 1.0, -1.0 );
+    int i = 0;
+
+    for( ; i + 2 <= pairs; i += 2 )
+    {
+      const __m256d va = _mm256_loadu_pd( a + 2 * i );
+      const __m256d vb = _mm256_loadu_pd( b + 2 * i );
+      const __m256d re = _mm256_movedup_pd( vb );
+      const __m256d im = _mm256_permute_pd( vb, 0xF );
+      const __m256d swapped = _mm256_permute_pd( va, 0x5 );
+      __m256d r = _mm256_add_pd( _mm256_mul_pd( va, re ), _mm256_mul_pd( _mm256_mul_pd( swapped, im ), sign ) );
+
+      if( accumulate )
+      {
+        r = _mm256_add_pd( r, _mm256_loadu_pd( dst + 2 * i ) );
+      }
+
+      _mm256_storeu_pd( dst + 2 * i, r );
+    }
+
+    complexMulSse2( a + 2 * i, b + 2 * i, dst + 2 * i, pairs - i, conjB, accumulate );
+  }
+
+  SPECTRUM_OPS_AVX2 void complexMulAvx2( const float * a, const float * b, float * dst, int pairs, bool conjB, bool accumulate )
+  {
+    const __m256 sign = conjB ?
+      _mm256_set_ps( -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f ) :
+      _mm256_set_ps( 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f );
+    int i = 0;
+
+    for( ; i + 4 <= pairs; i += 4 )
+    {
+      const __m256 va = _mm256_loadu_ps( a + 2 * i );
+      const __m256 vb = _mm256_loadu_ps( b + 2 * i );
+      const __m256 re = _mm256_moveldup_ps( vb );
+      const __m256 im = _mm256_movehdup_ps( vb );
+      const __m256 swapped = _mm256_permute_ps( va, _MM_SHUFFLE( 2, 3, 0, 1 ) );
+      __m256 r = _mm256_add_ps( _mm256_mul_ps( va, re ), _mm256_mul_ps( _mm256_mul_ps( swapped, im ), sign ) );
+
+      if( accumulate )
+      {
+        r = _mm256_add_ps( r, _mm256_loadu_ps( dst + 2 * i ) );
+      }
+
+      _mm256_storeu_ps( dst + 2 * i, r );
+    }
+
+    complexMulSse2( a + 2 * i, b + 2 * i, dst + 2 * i, pairs - i, conjB, accumulate );
+  }
+
+  SPECTRUM_OPS_AVX2 void complexDivAvx2( const double * a, const double * b, double * dst, int pairs )
+  {
+    const __m256d sign = _mm256_set_pd( -1.0, 1.0, -1.0, 1.0 );
+    int i = 0;
+
+    for( ; i + 2 <= pairs; i += 2 )
+    {
+      const __m256d va = _mm256_loadu_pd( a + 2 * i );
+      const __m256d vb = _mm256_loadu_pd( b + 2 * i );
+      const __m256d re = _mm256_movedup_pd( vb );
+      const __m256d im = _mm256_permute_pd( vb, 0xF );
+      const __m256d swapped = _mm256_permute_pd( va, 0x5 );
+      const __m256d numerator = _mm256_add_pd( _mm256_mul_pd( va, re ), _mm256_mul_pd( _mm256_mul_pd( swapped, im ), sign ) );
+      const __m256d squared = _mm256_mul_pd( vb, vb );
+      const __m256d denominator = _mm256_add_pd( squared, _mm256_permute_pd( squared, 0x5 ) );
+
+      _mm256_storeu_pd( dst + 2 * i, _mm256_div_pd( numerator, denominator ) );
+    }
+
+    complexDivSse2( a + 2 * i, b + 2 * i, dst + 2 * i, pairs - i );
+  }
+
+  SPECTRUM_OPS_AVX2 void complexDivAvx2( const float * a, const float * b, float * dst, int pairs )
+  {
+    const __m256 sign = _mm256_set_ps( -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f );
+    int i = 0;
+
+    for( ; i + 4 <= pairs; i += 4 )
+    {
+      const __m256 va = _mm256_loadu_ps( a + 2 * i );
+      const __m256 vb = _mm256_loadu_ps( b + 2 * i );
+      const __m256 re = _mm256_moveldup_ps( vb );
+      const __m256 im = _mm256_movehdup_ps( vb );
+      const __m256 swapped = _mm256_permute_ps( va, _MM_SHUFFLE( 2, 3, 0, 1 ) );
+      const __m256 numerator = _mm256_add_ps( _mm256_mul_ps( va, re ), _mm256_mul_ps( _mm256_mul_ps( swapped, im ), sign ) );
+      const __m256 squared = _mm256_mul_ps( vb, vb );
+      const __m256 denominator = _mm256_add_ps( squared, _mm256_permute_ps( squared, _MM_SHUFFLE( 2, 3, 0, 1 ) ) );
+
+      _mm256_storeu_ps( dst + 2 * i, _mm256_div_ps( numerator, denominator ) );
+    }
+
+    complexDivSse2( a + 2 * i, b + 2 * i, dst + 2 * i, pairs - i );
+  }
+
+  SPECTRUM_OPS_AVX2 void lerpAvx2( double * dst, const double * src, int n, double t )
+  {
+    const __m256d vs = _mm256_set1_pd( 1.0 - t );
+    const __m256d vt = _mm256_set1_pd( t );
+    int i = 0;
+
+    for( ; i + 4 <= n; i += 4 )
+    {
+      _mm256_storeu_pd( dst + i, _mm256_add_pd( _mm256_mul_pd( vs, _mm256_loadu_pd( dst + i ) ), _mm256_mul_pd( vt, _mm256_loadu_pd( src + i ) ) ) );
+    }
+
+    lerpSse2( dst + i, src + i, n - i, t );
+  }
+
+  SPECTRUM_OPS_AVX2 void lerpAvx2( float * dst, const float * src, int n, float t )
+  {
+    const __m256 vs = _mm256_set1_ps( 1.0f - t );
+    const __m256 vt = _mm256_set1_ps( t );
+    int i = 0;
+
+    for( ; i + 8 <= n; i += 8 )
+    {
+      _mm256_storeu_ps( dst + i, _mm256_add_ps( _mm256_mul_ps( vs, _mm256_loadu_ps( dst + i ) ), _mm256_mul_ps( vt, _mm256_loadu_ps( src + i ) ) ) );
+    }
+
+    lerpSse2( dst + i, src + i, n - i, t );
+  }
+
+  SPECTRUM_OPS_AVX2 double sumSquaresAvx2( const double * a, int n )
+  {
+    __m256d sum = _mm256_setzero_pd();
+    int i = 0;
+
+    for( ; i + 4 <= n; i += 4 )
+    {
+      const __m256d v = _mm256_loadu_pd( a + i );
+      sum = _mm256_add_pd( sum, _mm256_mul_pd( v, v ) );
+    }
+
+    double lanes[ 4 ];
+    _mm256_storeu_pd( lanes, sum );
+
+    return lanes[ 0 ] + lanes[ 1 ] + lanes[ 2 ] + lanes[ 3 ] + sumSquaresSse2( a + i, n - i );
+  }
+
+  SPECTRUM_OPS_AVX2 double sumSquaresAvx2( const float * a, int n )
+  {
+    __m256d sum = _mm256_setzero_pd();
+    int i = 0;
+
+    for( ; i + 8 <= n; i += 8 )
+    {
+      const __m256 v = _mm256_loadu_ps( a + i );
+      const __m256d low = _mm256_cvtps_pd( _mm256_castps256_ps128( v ) );
+      const __m256d high = _mm256_cvtps_pd( _mm256_extractf128_ps( v, 1 ) );
+      sum = _mm256_add_pd( sum, _mm256_add_pd( _mm256_mul_pd( low, low ), _mm256_mul_pd( high, high ) ) );
+    }
+
+    double lanes[ 4 ];
+    _mm256_storeu_pd( lanes, sum );
+
+    return lanes[ 0 ] + lanes[ 1 ] + lanes[ 2 ] + lanes[ 3 ] + sumSquaresSse2( a + i, n - i );
+  }
+#endif
+
+  template< typename T >
+  Kernels< T > selectKernels()
+  {
+    Kernels< T > result;
+
+#ifdef SPECTRUM_OPS_SSE2
+    if( cv::checkHardwareSupport( CV_CPU_AVX2 ) )
+    {
+      result.complexMul = complexMulAvx2;
+      result.complexDiv = complexDivAvx2;
+      result.lerp = lerpAvx2;
+      result.sumSquares = sumSquaresAvx2;
+    }
+    else
+    {
+      result.complexMul = complexMulSse2;
+      result.complexDiv = complexDivSse2;
+      result.lerp = lerpSse2;
+      result.sumSquares = sumSquaresSse2;
+    }
+#else
+    result.complexMul = complexMulScalar< T >;
+    result.complexDiv = complexDivScalar< T >;
+    result.lerp = lerpScalar< T >;
+    result.sumSquares = sumSquaresScalar< T >;
+#endif
+
+    return result;
+  }
+
+  template< typename T >
+  const Kernels< T > & kernels()
+  {
+    static const Kernels< T > instance = selectKernels< T >();
+    return instance;
+  }
+
+  enum class SpectrumOp { Mul, MulAdd, Div };
+
+  template< typename T >
+  void applyScalar( SpectrumOp op, T a, T b, T & dst )
+  {
+    switch( op )
+    {
+      case SpectrumOp::Mul: dst = a * b; break;
+      case SpectrumOp::MulAdd: dst += a * b; break;
+      case SpectrumOp::Div: dst = a / b; break;
+    }
+  }
+
+  // Walks the CCS layout of a, b and dst on the rows in rowRange: the packed
+  // first/last columns in scalar code, the interleaved interior of every row
+  // with the selected kernels. A pair in a packed column is owned by the row
+  // holding its real part, so disjoint row ranges never write the same element.
+  template< typename T >
+  void ccsBinary( SpectrumOp op, const cv::Mat & a, const cv::Mat & b, cv::Mat & dst, bool conjB, const cv::Range & rowRange )
+  {
+    const Kernels< T > & k = kernels< T >();
+    const int rows = a.rows, cols = a.cols;
+    const bool is1d = rows == 1;
+    const int j1 = cols - ( cols % 2 == 0 );
+    const int pairs = ( j1 - 1 ) / 2;
+
+    for( int row = rowRange.start; row < rowRange.end; ++row )
+    {
+      const T * dataA = a.ptr< T >( row );
+      const T * dataB = b.ptr< T >( row );
+      T * dataC = dst.ptr< T >( row );
+
+      if( is1d )
+      {
+        applyScalar( op, dataA[ 0 ], dataB[ 0 ], dataC[ 0 ] );
+
+        if( cols % 2 == 0 )
+        {
+          applyScalar( op, dataA[ j1 ], dataB[ j1 ], dataC[ j1 ] );
+        }
+      }
+      else
+      {
+        for( int col = 0; col < cols; col += std::max( cols - 1, 1 ) )
+        {
+          if( row == 0 || ( rows % 2 == 0 && row == rows - 1 ) )
+          {
+            applyScalar( op, dataA[ col ], dataB[ col ], dataC[ col ] );
+          }
+          else if( row % 2 == 1 )
+          {
+            T pairA[ 2 ] = { dataA[ col ], a.ptr< T >( row + 1 )[ col ] };
+            T pairB[ 2 ] = { dataB[ col ], b.ptr< T >( row + 1 )[ col ] };
+            T pairC[ 2 ] = { dataC[ col ], dst.ptr< T >( row + 1 )[ col ] };
+
+            if( op == SpectrumOp::Div )
+            {
+              complexDivScalar< T >( pairA, pairB, pairC, 1 );
+            }
+            else
+            {
+              complexMulScalar< T >( pairA, pairB, pairC, 1, conjB, op == SpectrumOp::MulAdd );
+            }
+
+            dataC[ col ] = pairC[ 0 ];
+            dst.ptr< T >( row + 1 )[ col ] = pairC[ 1 ];
+          }
+
+          if( cols % 2 == 1 )
+          {
+            break;
+          }
+        }
+      }
+
+      if( op == SpectrumOp::Div )
+      {
+        k.complexDiv( dataA + 1, dataB + 1, dataC + 1, pairs );
+      }
+      else
+      {
+        k.complexMul( dataA + 1, dataB + 1, dataC + 1, pairs, conjB, op == SpectrumOp::MulAdd );
+      }
+    }
+  }
+
+  void ccsBinary( SpectrumOp op, const cv::Mat & a, const cv::Mat & b, cv::Mat & dst, bool conjB, const cv::Range & rowRange )
+  {
+    CV_Assert( a.type() == b.type() && a.size() == b.size() );
+    CV_Assert( a.type() == CV_32FC1 || a.type() == CV_64FC1 );
+    CV_Assert( dst.type() == a.type() && dst.size() == a.size() );
+    CV_Assert( dst.data != a.data && dst.data != b.data );
+
+    if( a.depth() == CV_32F )
+    {
+      ccsBinary< float >( op, a, b, dst, conjB, rowRange );
+    }
+    else
+    {
+      ccsBinary< double >( op, a, b, dst, conjB, rowRange );
+    }
+  }
+
+  template< typename T >
+  void lerpInPlace( cv::Mat & dst, const cv::Mat & src, T t )
+  {
+    const Kernels< T > & k = kernels< T >();
+    const int n = dst.cols * dst.channels();
+
+    if( dst.isContinuous() && src.isContinuous() )
+    {
+      k.lerp( dst.ptr< T >(), src.ptr< T >(), n * dst.rows, t );
+      return;
+    }
+
+    for( int row = 0; row < dst.rows; ++row )
+    {
+      k.lerp( dst.ptr< T >( row ), src.ptr< T >( row ), n, t );
+    }
+  }
+
+  template< typename T >
+  double squaredNormCcs( const cv::Mat & spectrum )
+  {
+    const Kernels< T > & k = kernels< T >();
+    const int rows = spectrum.rows, cols = spectrum.cols;
+    double sum = 0.0;
+
+    if( spectrum.isContinuous() )
+    {
+      sum = k.sumSquares( spectrum.ptr< T >(), rows * cols );
+    }
+    else
+    {
+      for( int row = 0; row < rows; ++row )
+      {
+        sum += k.sumSquares( spectrum.ptr< T >( row ), cols );
+      }
+    }
+
+    // Every stored value has a conjugate twin in the full spectrum, except
+    // for the purely real entries at the DC and Nyquist frequencies
+    double single = 0.0;
+    const auto addSingle = [&spectrum, &single]( int row, int col ) -> void
+    {
+      const double v = static_cast< double >( spectrum.ptr< T >( row )[ col ] );
+      single += v * v;
+    };
+
+    addSingle( 0, 0 );
+
+    if( rows == 1 )
+    {
+      if( cols % 2 == 0 )
+      {
+        addSingle( 0, cols - 1 );
+      }
+    }
+    else
+    {
+      if( rows % 2 == 0 )
+      {
+        addSingle( rows - 1, 0 );
+      }
+      if( cols % 2 == 0 && cols > 1 )
+      {
+        addSingle( 0, cols - 1 );
+
+        if( rows % 2 == 0 )
+        {
+          addSingle( rows - 1, cols - 1 );
+        }
+      }
+    }
+
+    return 2.0 * sum - single;
+  }
+}
+
+void mulSpectrumsCcs( const cv::Mat & a, const cv::Mat & b, cv::Mat & dst, bool conjB )
+{
+  if( dst.data == a.data || dst.data == b.data )
+  {
+    dst.release();
+  }
+
+  dst.create( a.size(), a.type() );
+  ccsBinary( SpectrumOp::Mul, a, b, dst, conjB, cv::Range( 0, a.rows ) );
+}
+
+void mulAddSpectrumsCcs( const cv::Mat & a, const cv::Mat & b, cv::Mat & dst, bool conjB, const cv::Range & rowRange )
+{
+  ccsBinary( SpectrumOp::MulAdd, a, b, dst, conjB, rowRange );
+}
+
+void divSpectrumsCcs( const cv::Mat & a, const cv::Mat & b, cv::Mat & dst )
+{
+  if( dst.data == a.data || dst.data == b.data )
+  {
+    dst.release();
+  }
+
+  dst.create( a.size(), a.type() );
+  ccsBinary( SpectrumOp::Div, a, b, dst, false, cv::Range( 0, a.rows ) );
+}
+
+void lerpInPlace( cv::Mat & dst, const cv::Mat & src, double t )
+{
+  CV_Assert( dst.type() == src.type() && dst.size() == src.size() );
+  CV_Assert( dst.depth() == CV_32F || dst.depth() == CV_64F );
+
+  if( dst.depth() == CV_32F )
+  {
+    lerpInPlace< float >( dst, src, static_cast< float >( t ) );
+  }
+  else
+  {
+    lerpInPlace< double >( dst, src, t );
+  }
+}
+
+double squaredNormCcs( const cv::Mat & spectrum )
+{
+  CV_Assert( spectrum.type() == CV_32FC1 || spectrum.type() == CV_64FC1 );
+
+  if( spectrum.depth() == CV_32F )
+  {
+    return squaredNormCcs< float >( spectrum );
+  }
+
+  return squaredNormCcs< double >( spectrum );
+}
+
+namespace
+{
+  template< typename T >
+  void shiftSpectrumCcs( const cv::Mat & src, cv::Mat & dst, const cv::Point2d & shift )
+  {
+    typedef std::complex< double > Complex;
+
+    const int rows = src.rows, cols = src.cols;
+    const double pi = CV_PI;
+    const int j1 = cols - ( cols % 2 == 0 );
+    std::vector< Complex > phaseX( cols / 2 + 1 );
+    std::vector< Complex > phaseY( rows );
+
+    // exp( 2 pi i k shift / n ), with signed frequencies along y, so that sub-cell shifts interpolate smoothly
+    for( int k = 0; k < static_cast< int >( phaseX.size() ); ++k )
+    {
+      phaseX[ k ] = std::polar( 1.0, 2.0 * pi * k * shift.x / cols );
+    }
+    for( int k = 0; k < rows; ++k )
+    {
+      const int signedK = ( k <= rows / 2 ) ? k : k - rows;
+      phaseY[ k ] = std::polar( 1.0, 2.0 * pi * signedK * shift.y / rows );
+    }
+
+    const auto rotate = []( const T * in, T * out, const Complex & phase ) -> void
+    {
+      const Complex value = Complex( in[ 0 ], in[ 1 ] ) * phase;
+      out[ 0 ] = static_cast< T >( value.real() );
+      out[ 1 ] = static_cast< T >( value.imag() );
+    };
+
+    if( rows == 1 )
+    {
+      const T * in = src.ptr< T >();
+      T * out = dst.ptr< T >();
+
+      out[ 0 ] = in[ 0 ];
+
+      for( int col = 1; col < j1; col += 2 )
+      {
+        rotate( in + col, out + col, phaseX[ ( col + 1 ) / 2 ] );
+      }
+
+      if( cols % 2 == 0 )
+      {
+        out[ cols - 1 ] = static_cast< T >( in[ cols - 1 ] * phaseX[ cols / 2 ].real() );
+      }
+
+      return;
+    }
+
+    // The packed columns hold the spectra of real sequences, so their Nyquist terms must stay
+    // real; only the real part of the phase is applied to those, which is exact for whole cell shifts
+    for( int col = 0; col < cols; col += std::max( cols - 1, 1 ) )
+    {
+      const double factorX = phaseX[ col == 0 ? 0 : cols / 2 ].real();
+
+      dst.ptr< T >( 0 )[ col ] = static_cast< T >( src.ptr< T >( 0 )[ col ] * factorX );
+
+      for( int row = 1; row + 1 < rows; row += 2 )
+      {
+        const T in[ 2 ] = { src.ptr< T >( row )[ col ], src.ptr< T >( row + 1 )[ col ] };
+        T out[ 2 ];
+
+        rotate( in, out, phaseY[ ( row + 1 ) / 2 ] * factorX );
+        dst.ptr< T >( row )[ col ] = out[ 0 ];
+        dst.ptr< T >( row + 1 )[ col ] = out[ 1 ];
+      }
+
+      if( rows % 2 == 0 )
+      {
+        dst.ptr< T >( rows - 1 )[ col ] = static_cast< T >( src.ptr< T >( rows - 1 )[ col ] * factorX * phaseY[ rows / 2 ].real() );
+      }
+
+      if( cols % 2 == 1 )
+      {
+        break;
+      }
+    }
+
+    for( int row = 0; row < rows; ++row )
+    {
+      const T * in = src.ptr< T >( row );
+      T * out = dst.ptr< T >( row );
+
+      for( int col = 1; col < j1; col += 2 )
+      {
+        rotate( in + col, out + col, phaseX[ ( col + 1 ) / 2 ] * phaseY[ row ] );
+      }
+    }
+  }
+}
+
+void shiftSpectrumCcs( const cv::Mat & src, cv::Mat & dst, const cv::Point2d & shift )
+{
+  CV_Assert( src.type() == CV_32FC1 || src.type() == CV_64FC1 );
+
+  if( dst.data != src.data )
+  {
+    dst.create( src.size(), src.type() );
+  }
+
+  if( src.depth() == CV_32F )
+  {
+    shiftSpectrumCcs< float >( src, dst, shift );
+  }
+  else
+  {
+    shiftSpectrumCcs< double >( src, dst, shift );
+  }
+}
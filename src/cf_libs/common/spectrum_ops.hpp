@@ -0,0 +1,82 @@
+#ifndef _SPECTRUM_OPS_HPP_
+#define _SPECTRUM_OPS_HPP_
+/*
+// License Agreement (3-clause BSD License)
+// Copyright (c) 2016, Jake Hall, Massimo Camplan, Sion Hannuna.
+// Third party copyrights and patents are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the names of the copyright holders nor the names of the contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall copyright holders or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+*/
+
+/*
+Vectorised element-wise operations on CCS packed spectra (see cv::dft) and
+on real model buffers. These replace cv::mulSpectrums and the expression
+template blends on the model update path.
+
+The interior of every CCS row is a run of interleaved complex numbers, which
+is processed by SSE2 or AVX2 kernels selected once at run time; the packed
+first/last columns are handled in scalar code. All functions accept CV_32FC1
+and CV_64FC1 input.
+*/
+
+#include <opencv2/core/core.hpp>
+
+/**
+ * dst = a * b, or a * conj( b ), for CCS packed spectra.
+ * dst is (re)allocated unless it already has the size and type of a.
+ */
+void mulSpectrumsCcs( const cv::Mat & a, const cv::Mat & b, cv::Mat & dst, bool conjB = false );
+
+/**
+ * dst += a * b, or a * conj( b ), for CCS packed spectra, on the rows in rowRange only.
+ * Disjoint row ranges may be processed in parallel on the same dst.
+ */
+void mulAddSpectrumsCcs( const cv::Mat & a, const cv::Mat & b, cv::Mat & dst, bool conjB, const cv::Range & rowRange );
+
+/**
+ * dst = a / b for CCS packed spectra.
+ */
+void divSpectrumsCcs( const cv::Mat & a, const cv::Mat & b, cv::Mat & dst );
+
+/**
+ * dst = ( 1 - t ) * dst + t * src, in place, without any temporary.
+ */
+void lerpInPlace( cv::Mat & dst, const cv::Mat & src, double t );
+
+/**
+ * @returns The sum of the squared magnitudes over the full spectrum represented by
+ *   a CCS packed spectrum, i.e. the sum of the real parts of spectrum * conj( spectrum ).
+ */
+double squaredNormCcs( const cv::Mat & spectrum );
+
+/**
+ * Applies the Fourier shift theorem to a CCS packed spectrum: if src is the spectrum of
+ * z, dst becomes the spectrum of the cyclically shifted z'( q ) = z( q + shift ). Sub-cell
+ * shifts are supported; dst may be src.
+ */
+void shiftSpectrumCcs( const cv::Mat & src, cv::Mat & dst, const cv::Point2d & shift );
+
+#endif
@@ -0,0 +1,121 @@
+#ifndef _DSKCF_PARAMETERS_HPP_
+#define _DSKCF_PARAMETERS_HPP_
+/*
+// License Agreement (3-clause BSD License)
+// Copyright (c) 2016, Jake Hall, Massimo Camplan, Sion Hannuna.
+// Third party copyrights and patents are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the names of the copyright holders nor the names of the contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall copyright holders or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+*/
+
+#include <memory>
+#include <string>
+
+#include "ExecutionPolicy.hpp"
+
+class DenseHOGFeatureExtractor;
+
+/**
+ * DskcfParameters holds the run time options of the DS-KCF tracker which are
+ * not part of the KCF model itself.
+ */
+struct DskcfParameters
+{
+	/** The kernel of the correlation filters: "gaussian", "linear" or "polynomial" */
+	std::string kernel = "gaussian";
+
+	/** The features extracted from the colour and depth maps: "hog" or "raw", see RawFeatureExtractor */
+	std::string features = "hog";
+
+	/**
+	 * How the features of the colour and depth maps are turned into models: "concatenate", "colour",
+	 * "depth" or "linear", see the FeatureChannelProcessor implementations
+	 */
+	std::string channels = "concatenate";
+
+	/**
+	 * The number of channels every model compresses its features to with an online PCA, see FeatureProjection.
+	 * Fewer channels make every transform and kernel correlation cheaper; 0 keeps all channels
+	 */
+	int projectedChannels = 0;
+
+	/** The size of a feature cell in pixels, the smallest cell size of any scale */
+	int cellSize = 4;
+
+	/**
+	 * The largest number of feature cells of a model. The cells of a scale whose padded window would exceed it
+	 * grow until it fits, bounding the cost of a frame however close the target gets; 0 keeps cellSize for every scale
+	 */
+	int maxModelCells = 0;
+
+	/** Sum the kernel correlation over the channels in the Fourier domain (one inverse DFT per correlation) */
+	bool fourierKernelSum = true;
+
+	/** Grow the feature grid of every scale to the next size with only 2, 3 and 5 as prime factors */
+	bool optimalDftSizes = false;
+
+	/** Print the feature grid and estimated DFT cost of every scale whenever the tracker is initialised */
+	bool reportDftCosts = false;
+
+	/** Train on the detection spectrum shifted to the new position instead of extracting new features */
+	bool reuseDetectionSpectrum = false;
+
+	/** The largest shift, in feature cells, for which the detection spectrum is reused */
+	double maxSpectrumShift = 2.0;
+
+	/** Search the whole frame for the target once it is lost, see Redetector */
+	bool redetection = false;
+
+	/** With redetection, the target is lost when the maximum response falls below this value */
+	double lossThreshold = 0.15;
+
+	/** The normalised, depth weighted response a full frame candidate needs to be accepted */
+	double redetectionThreshold = 0.5;
+
+	/** The maximum number of feature cells searched by the redetection; larger frames are downscaled */
+	int redetectionMaxCells = 1 << 14;
+
+	/**
+	 * Detect at the current scale and its two neighbours in one batch and switch to the best one,
+	 * instead of following the depth of the target. Meant for scenes where the depth is unreliable
+	 */
+	bool multiScaleDetection = false;
+
+	/** The factor applied to the response of the neighbouring scales of a multi-scale detection */
+	double scalePenalty = 0.95;
+
+	/**
+	 * Crop the HOG features of every window from one whole frame map instead of extracting them per window.
+	 * Trackers created with the same parameters share the maps; null extracts per window. Only used with "hog" features.
+	 * Every cell size costs a pass over the frame, so this only pays off for several trackers, see SORTTR
+	 */
+	std::shared_ptr< DenseHOGFeatureExtractor > denseFeatures;
+
+	/** The scheduling of the data parallel loops of the tracker */
+	ExecutionPolicy execution;
+};
+
+#endif
@@ -1,4 +1,5 @@
 #include "FeatureExtractor.hpp"
+#include "ExecutionPolicy.hpp"
 
 FeatureExtractor::FeatureExtractor()
 {
@@ -7,3 +8,18 @@ FeatureExtractor::FeatureExtractor()
 FeatureExtractor::~FeatureExtractor()
 {
 }
+
+std::vector< std::shared_ptr< FC > > FeatureExtractor::getFeaturesBatch( const cv::Mat & image,
+	const std::vector< cv::Rect_< double > > & boundingBoxes, int cellSize ) const
+{
+	std::vector< std::shared_ptr< FC > > result( boundingBoxes.size() );
+
+	parallelFor< size_t >( 0, boundingBoxes.size(),
+		[this, &image, &boundingBoxes, cellSize, &result]( size_t index ) -> void
+		{
+			result[ index ] = this->getFeatures( image, boundingBoxes[ index ], cellSize );
+		}
+	);
+
+	return result;
+}
@@ -43,6 +43,7 @@ DS-KCF: A ~real-time tracker for RGB-D data, Journal of Real-Time Image Processi
 */
 
 #include <array>
+#include <vector>
 #include "feature_channels.hpp"
 #include <opencv2/core.hpp>
 
@@ -52,7 +53,25 @@ public:
 	FeatureExtractor();
 	virtual ~FeatureExtractor();
 
-	virtual std::shared_ptr< FC > getFeatures( const cv::Mat & image, const cv::Rect_< double > & boundingBox ) const = 0;
+	/**
+	 * @param image The colour image or depth map to extract the features from.
+	 * @param boundingBox The window to extract, the same pixels as getSubWindow.
+	 * @param cellSize The size of a feature cell in pixels; the features form a grid of
+	 *   floor( window / cellSize ) cells, as the labels and cosine window of the scale, see ScaleAnalyser.
+	 *
+	 * @returns The features of the window, or null if they cannot be extracted.
+	 */
+	virtual std::shared_ptr< FC > getFeatures( const cv::Mat & image, const cv::Rect_< double > & boundingBox, int cellSize ) const = 0;
+
+	/**
+	 * Extracts the features of several windows of the same image, as getFeatures would for each of them.
+	 * The windows are extracted in parallel; extractors may override this to share work between the
+	 * windows, such as the image gradients.
+	 *
+	 * @returns The features of each window, in the order of boundingBoxes.
+	 */
+	virtual std::vector< std::shared_ptr< FC > > getFeaturesBatch( const cv::Mat & image,
+		const std::vector< cv::Rect_< double > > & boundingBoxes, int cellSize ) const;
 
 private:
 };
@@ -0,0 +1,186 @@
+#ifndef _FEATUREPIPELINE_HPP_
+#define _FEATUREPIPELINE_HPP_
+/*
+// License Agreement (3-clause BSD License)
+// Copyright (c) 2016, Jake Hall, Massimo Camplan, Sion Hannuna.
+// Third party copyrights and patents are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the names of the copyright holders nor the names of the contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall copyright holders or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+*/
+
+/*
+FeaturePipeline bundles the per frame glue between the feature extractor and
+the feature channel processor: extracting the features of the RGB and depth
+maps, windowing them and processing them into the features of every model.
+OcclusionHandler and Redetector share one pipeline.
+*/
+
+#include <array>
+#include <memory>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#include "Typedefs.hpp"
+#include "feature_channels.hpp"
+#include "ExecutionPolicy.hpp"
+#include "FeatureExtractor.hpp"
+#include "FeatureChannelProcessor.hpp"
+
+class FeaturePipeline
+{
+public:
+	FeaturePipeline( const std::shared_ptr< FeatureExtractor > & features, const std::shared_ptr< FeatureChannelProcessor > & processor ) :
+		m_features( features ),
+		m_processor( processor )
+	{
+	}
+
+	/**
+	 * Extracts the features of the RGB and depth maps inside window.
+	 *
+	 * @param frame The RGB and depth maps for the current frame.
+	 * @param window The region to extract the features from.
+	 * @param cellSize The size of a feature cell in pixels, see FeatureExtractor::getFeatures.
+	 * @param cosineWindow The window every channel is multiplied with, or an empty Mat to leave the features as they are.
+	 * @param[out] features The features of each map, in the order of frame. An entry is null if its extraction failed.
+	 */
+	void extract( const std::array< cv::Mat, 2 > & frame, const Rect & window, int cellSize, const cv::Mat & cosineWindow,
+		std::vector< std::shared_ptr< FC > > & features ) const
+	{
+		const FeatureExtractor & extractor = *this->m_features;
+
+		features.resize( frame.size() );
+
+		parallelFor< size_t >( 0, frame.size(),
+			[&extractor, &frame, &window, cellSize, &cosineWindow, &features]( size_t index ) -> void
+			{
+				features[ index ] = extractor.getFeatures( frame[ index ], window, cellSize );
+
+				if( features[ index ] && !cosineWindow.empty() )
+				{
+					FC::mulFeatures( features[ index ], cosineWindow );
+				}
+			}
+		);
+	}
+
+	/**
+	 * Turns the features of each map into the features of each model, see FeatureChannelProcessor.
+	 */
+	void process( std::vector< std::shared_ptr< FC > > & features ) const
+	{
+		features = this->m_processor->concatenate( features );
+	}
+
+	/**
+	 * Extracts, windows and processes the features in one step.
+	 *
+	 * @param[out] features The features of every model.
+	 */
+	void extractProcessed( const std::array< cv::Mat, 2 > & frame, const Rect & window, int cellSize, const cv::Mat & cosineWindow,
+		std::vector< std::shared_ptr< FC > > & features ) const
+	{
+		this->extract( frame, window, cellSize, cosineWindow, features );
+		this->process( features );
+	}
+
+	/**
+	 * Extracts the features of several windows of the same frame, see FeatureExtractor::getFeaturesBatch.
+	 *
+	 * @param[out] features The features of each map for each window, indexed as features[ window ][ map ].
+	 */
+	void extractBatch( const std::array< cv::Mat, 2 > & frame, const std::vector< Rect > & windows, int cellSize,
+		const cv::Mat & cosineWindow, std::vector< std::vector< std::shared_ptr< FC > > > & features ) const
+	{
+		const FeatureExtractor & extractor = *this->m_features;
+		std::array< std::vector< std::shared_ptr< FC > >, 2 > maps;
+
+		parallelFor< size_t >( 0, frame.size(),
+			[&extractor, &frame, &windows, cellSize, &cosineWindow, &maps]( size_t index ) -> void
+			{
+				maps[ index ] = extractor.getFeaturesBatch( frame[ index ], windows, cellSize );
+
+				for( std::shared_ptr< FC > & windowFeatures : maps[ index ] )
+				{
+					if( windowFeatures && !cosineWindow.empty() )
+					{
+						FC::mulFeatures( windowFeatures, cosineWindow );
+					}
+				}
+			}
+		);
+
+		features.assign( windows.size(), std::vector< std::shared_ptr< FC > >( frame.size() ) );
+
+		for( size_t window = 0; window < windows.size(); ++window )
+		{
+			for( size_t index = 0; index < frame.size(); ++index )
+			{
+				features[ window ][ index ] = maps[ index ][ window ];
+			}
+		}
+	}
+
+	/**
+	 * Extracts, windows and processes the features of several windows in one step.
+	 *
+	 * @param[out] features The features of every model for each window, indexed as features[ window ][ model ].
+	 */
+	void extractBatchProcessed( const std::array< cv::Mat, 2 > & frame, const std::vector< Rect > & windows, int cellSize,
+		const cv::Mat & cosineWindow, std::vector< std::vector< std::shared_ptr< FC > > > & features ) const
+	{
+		this->extractBatch( frame, windows, cellSize, cosineWindow, features );
+
+		parallelFor< size_t >( 0, features.size(),
+			[this, &features]( size_t window ) -> void
+			{
+				this->process( features[ window ] );
+			}
+		);
+	}
+
+	/**
+	 * @returns The image each model detects on, see FeatureChannelProcessor.
+	 */
+	const std::vector< cv::Mat > modelImages( const std::array< cv::Mat, 2 > & frame ) const
+	{
+		return this->m_processor->concatenate( std::vector< cv::Mat >( frame.begin(), frame.end() ) );
+	}
+
+	/**
+	 * @returns The position combined from the positions found by every model.
+	 */
+	const Point combine( const std::vector< Point > & positions ) const
+	{
+		return this->m_processor->concatenate( positions );
+	}
+private:
+	std::shared_ptr< FeatureExtractor > m_features;
+	std::shared_ptr< FeatureChannelProcessor > m_processor;
+};
+
+#endif
@@ -2,14 +2,28 @@
 
 #include <tbb/concurrent_vector.h>
 
-OcclusionHandler::OcclusionHandler( KcfParameters paras, std::shared_ptr< Kernel > & kernel, std::shared_ptr< FeatureExtractor > & featureExtractor, std::shared_ptr< FeatureChannelProcessor > & featureProcessor )
+#include "ExecutionPolicy.hpp"
+
+OcclusionHandler::OcclusionHandler( KcfParameters paras, std::shared_ptr< Kernel > & kernel, const std::shared_ptr< FeaturePipeline > & pipeline,
+  const DskcfParameters & dskcfParas )
 {
   this->m_paras = paras;
+  this->m_executionPolicy = dskcfParas.execution;
+  this->m_redetection = dskcfParas.redetection;
+  this->m_lossThreshold = dskcfParas.lossThreshold;
+  this->m_numberOfModels = 0;
+  this->m_reuseDetectionSpectrum = dskcfParas.reuseDetectionSpectrum;
+  this->m_maxSpectrumShift = dskcfParas.maxSpectrumShift;
+  this->m_multiScaleDetection = dskcfParas.multiScaleDetection;
+  this->m_scalePenalty = dskcfParas.scalePenalty;
+  this->m_reportDftCosts = dskcfParas.reportDftCosts;
   this->m_kernel = kernel;
-  this->m_featureExtractor = featureExtractor;
-  this->m_featureProcessor = featureProcessor;
+  this->m_pipeline = pipeline;
   this->m_depthSegmenter = std::make_shared< DepthSegmenter >();
-  this->m_scaleAnalyser = std::make_shared< ScaleAnalyser >( this->m_depthSegmenter.get(), paras.padding );
+  this->m_cellSize = paras.cellSize;
+  this->m_scaleAnalyser = std::make_shared< ScaleAnalyser >( this->m_depthSegmenter.get(), paras.padding, paras.cellSize,
+    dskcfParas.maxModelCells, dskcfParas.optimalDftSizes );
+  this->m_redetector = std::make_shared< Redetector >( pipeline, dskcfParas );
 
   for( int i = 0; i < 2; i++ )
   {
@@ -33,6 +47,7 @@ OcclusionHandler::~OcclusionHandler()
 
 void OcclusionHandler::init( const std::array< cv::Mat, 2 > & frame, const Rect & target )
 {
+  ExecutionPolicy::Scope scope( this->m_executionPolicy );
   std::vector< std::shared_ptr< FC > > features( 2 );
   //this->m_isOccluded = false;
   this->m_initialSize = target.size();
@@ -44,17 +59,17 @@ void OcclusionHandler::init( const std::array< cv::Mat, 2 > & frame, const Rect
   this->m_depthSegmenter->init( frame[ 1 ], target );
   this->m_scaleAnalyser->init( frame[ 1 ], target );
 
+  if( this->m_reportDftCosts )
+  {
+    this->m_scaleAnalyser->printDftCosts( std::cout );
+  }
+
   Point position = centerPoint( target );
   Rect window = boundingBoxFromPointSize( position, this->m_windowSize );
 
   //Extract features
-  for( int i = 0; i < 2; i++ )
-  {
-    features[ i ] = this->m_featureExtractor->getFeatures( frame[ i ], window );
-    FC::mulFeatures( features[ i ], this->m_cosineWindow );
-  }
-
-  features = this->m_featureProcessor->concatenate( features );
+  this->m_pipeline->extractProcessed( frame, window, this->m_cellSize, this->m_cosineWindow, features );
+  this->m_numberOfModels = features.size();
 
   for( uint i = 0; i < features.size(); i++ )
   {
@@ -66,16 +81,19 @@ void OcclusionHandler::init( const std::array< cv::Mat, 2 > & frame, const Rect
 
 const boost::optional< Rect > OcclusionHandler::detect( const std::array< cv::Mat, 2 > & frame, const Point & position )
 {
+  ExecutionPolicy::Scope scope( this->m_executionPolicy );
   return this->visibleDetect( frame, position );
 }
 
 void OcclusionHandler::update( const std::array< cv::Mat, 2 > & frame, const Point & position )
 {
+  ExecutionPolicy::Scope scope( this->m_executionPolicy );
   return this->visibleUpdate( frame, position );
 }
 
 const float OcclusionHandler::score( const std::array< cv::Mat, 2 > & frame, const Point & position )
 {
+  ExecutionPolicy::Scope scope( this->m_executionPolicy );
   std::vector< double > responses;
   std::vector< std::shared_ptr< FC > > features( 2 );
   std::vector< Point > positions;
@@ -83,16 +101,8 @@ const float OcclusionHandler::score( const std::array< cv::Mat, 2 > & frame, con
   //Rect target = boundingBoxFromPointSize( position, this->m_targetSize );
   Rect window = boundingBoxFromPointSize( position, this->m_windowSize );
 
-  tbb::parallel_for< uint >( 0, 2, 1,
-	  [this,&frame,&features,&window]( uint index ) -> void
-	  {
-		  features[ index ] = this->m_featureExtractor->getFeatures( frame[ index ], window );
-		  FC::mulFeatures( features[ index ], this->m_cosineWindow );
-	  }
-  );
-
-  features = this->m_featureProcessor->concatenate( features );
-  std::vector< cv::Mat > frames_ = this->m_featureProcessor->concatenate( std::vector< cv::Mat >( frame.begin(), frame.end() ) );
+  this->m_pipeline->extractProcessed( frame, window, this->m_cellSize, this->m_cosineWindow, features );
+  std::vector< cv::Mat > frames_ = this->m_pipeline->modelImages( frame );
 
   for( uint i = 0; i < features.size(); i++ )
   {
@@ -104,6 +114,47 @@ const float OcclusionHandler::score( const std::array< cv::Mat, 2 > & frame, con
   return responses[ 0 ];
 }
 
+const std::vector< float > OcclusionHandler::score( const std::array< cv::Mat, 2 > & frame, const std::vector< Point > & positions )
+{
+  ExecutionPolicy::Scope scope( this->m_executionPolicy );
+  std::vector< float > scores( positions.size() );
+  std::vector< std::vector< std::shared_ptr< FC > > > features;
+  std::vector< Rect > windows( positions.size() );
+
+  for( size_t i = 0; i < positions.size(); i++ )
+  {
+    windows[ i ] = boundingBoxFromPointSize( positions[ i ], this->m_windowSize );
+  }
+
+  this->m_pipeline->extractBatchProcessed( frame, windows, this->m_cellSize, this->m_cosineWindow, features );
+  std::vector< cv::Mat > frames_ = this->m_pipeline->modelImages( frame );
+
+  // Detection does not change the trackers, so the windows are scored concurrently; only the first model is scored
+  parallelFor< size_t >( 0, positions.size(),
+    [this, &frames_, &features, &positions, &scores]( size_t i ) -> void
+    {
+      DetectResult result = this->m_targetTracker[ 0 ]->detect( frames_[ 0 ], features[ i ][ 0 ], positions[ i ], this->m_depthSegmenter->getTargetDepth(), this->m_depthSegmenter->getTargetSTD() );
+      scores[ i ] = static_cast< float >( result.maxResponse );
+    }
+  );
+
+  return scores;
+}
+
+const boost::optional< Rect > OcclusionHandler::redetect( const std::array< cv::Mat, 2 > & frame )
+{
+  ExecutionPolicy::Scope scope( this->m_executionPolicy );
+  std::vector< KcfTracker::SpatialFilter > filters( this->m_numberOfModels );
+
+  for( size_t i = 0; i < filters.size(); i++ )
+  {
+    filters[ i ] = this->m_targetTracker[ i ]->getSpatialFilter();
+  }
+
+  return this->m_redetector->detect( frame, filters, this->m_initialSize * this->m_scaleAnalyser->getScaleFactor(),
+    this->m_depthSegmenter->getTargetDepth(), this->m_depthSegmenter->getTargetSTD() );
+}
+
 const boost::optional< Rect > OcclusionHandler::visibleDetect( const std::array< cv::Mat, 2 > & frame, const Point & position )
 {
   std::vector< double > responses;
@@ -113,23 +164,32 @@ const boost::optional< Rect > OcclusionHandler::visibleDetect( const std::array<
   Rect target = boundingBoxFromPointSize( position, this->m_targetSize );
   Rect window = boundingBoxFromPointSize( position, this->m_windowSize );
 
-  tbb::parallel_for< uint >( 0, 2, 1,
-	  [this,&frame,&features,&window]( uint index ) -> void
-	  {
-		  features[ index ] = this->m_featureExtractor->getFeatures( frame[ index ], window );
-		  FC::mulFeatures( features[ index ], this->m_cosineWindow );
-	  }
-  );
+  this->m_detectionSpectra.clear();
+  this->m_detectionPosition = position;
+
+  if( this->m_multiScaleDetection )
+  {
+    this->multiScaleDetect( frame, position, positions, responses );
+  }
+  else
+  {
+    this->m_pipeline->extractProcessed( frame, window, this->m_cellSize, this->m_cosineWindow, features );
+    std::vector< cv::Mat > frames_ = this->m_pipeline->modelImages( frame );
 
-  features = this->m_featureProcessor->concatenate( features );
-  std::vector< cv::Mat > frames_ = this->m_featureProcessor->concatenate( std::vector< cv::Mat >( frame.begin(), frame.end() ) );
+    for( uint i = 0; i < features.size(); i++ )
+    {
+      DetectResult result = this->m_targetTracker[ i ]->detect( frames_[ i ], features[ i ], position, this->m_depthSegmenter->getTargetDepth(), this->m_depthSegmenter->getTargetSTD() );
+      positions.push_back( result.position );
+      responses.push_back( result.maxResponse );
+      this->m_detectionSpectra.push_back( result.zf );
+    }
+  }
 
-  for( uint i = 0; i < features.size(); i++ )
+  if( this->m_redetection && *std::max_element( responses.begin(), responses.end() ) < this->m_lossThreshold )
   {
-    DetectResult result = this->m_targetTracker[ i ]->detect( frames_[ i ], features[ i ], position, this->m_depthSegmenter->getTargetDepth(), this->m_depthSegmenter->getTargetSTD() );
-    positions.push_back( result.position );
-    responses.push_back( result.maxResponse );
+    return boost::none;
   }
+
   //here the maximun response is calculated....
   //TO BE CHECKED IN CASE OF MULTIPLE MODELS...LINEAR ETC....WORKS ONLY FOR SINGLE (or concatenate) features
   target = boundingBoxFromPointSize( positions.back(), this->m_targetSize );
@@ -140,7 +200,7 @@ const boost::optional< Rect > OcclusionHandler::visibleDetect( const std::array<
   double totalArea=target.area()*1.05;
 
 	//here the maximun response is calculated....
-  Point estimate = this->m_featureProcessor->concatenate( positions );
+  Point estimate = this->m_pipeline->combine( positions );
 
 	estimate.x=(estimate.x -this->m_targetSize.width/2)<	frame[ 0 ].cols	 ? estimate.x : this->m_targetSize.width;
 	estimate.y=(estimate.y -this->m_targetSize.height/2)<	frame[ 0 ].rows	 ? estimate.y : this->m_targetSize.height;
@@ -149,6 +209,84 @@ const boost::optional< Rect > OcclusionHandler::visibleDetect( const std::array<
   return boundingBoxFromPointSize( estimate, this->m_initialSize * this->m_scaleAnalyser->getScaleFactor() );
 }
 
+void OcclusionHandler::multiScaleDetect( const std::array< cv::Mat, 2 > & frame, const Point & position, std::vector< Point > & positions, std::vector< double > & responses )
+{
+  const size_t current = this->m_scaleAnalyser->getScaleIndex();
+  const size_t first = ( current > 0 ) ? current - 1 : current;
+  const size_t last = std::min( current + 1, this->m_scaleAnalyser->getScaleCount() - 1 );
+  const size_t scaleCount = last - first + 1;
+
+  //Extract the features once, for the window of the largest scale with the cells of the current one
+  const Size largestWindow = this->m_scaleAnalyser->getWindowSize( last );
+  Rect window = boundingBoxFromPointSize( position, largestWindow );
+  std::vector< std::shared_ptr< FC > > largest;
+
+  this->m_pipeline->extract( frame, window, this->m_cellSize, cv::Mat(), largest );
+
+  //Crop the window of every scale out of the largest grid and resample it to the model grid
+  const cv::Size grid = largest[ 0 ]->channels[ 0 ].size();
+  const cv::Size modelGrid = this->m_cosineWindow.size();
+  std::vector< std::vector< std::shared_ptr< FC > > > candidates( scaleCount );
+  std::vector< double > cellScales( scaleCount );
+
+  for( size_t s = 0; s < scaleCount; s++ )
+  {
+    const Size windowSize = this->m_scaleAnalyser->getWindowSize( first + s );
+    std::vector< std::shared_ptr< FC > > features( 2 );
+    cv::Rect roi;
+
+    roi.width = std::max( 1, std::min( grid.width, cvRound( grid.width * windowSize.width / largestWindow.width ) ) );
+    roi.height = std::max( 1, std::min( grid.height, cvRound( grid.height * windowSize.height / largestWindow.height ) ) );
+    roi.x = ( grid.width - roi.width ) / 2;
+    roi.y = ( grid.height - roi.height ) / 2;
+
+    cellScales[ s ] = windowSize.width / this->m_windowSize.width;
+
+    for( int i = 0; i < 2; i++ )
+    {
+      features[ i ] = FC::resizeFeatures( largest[ i ], roi, modelGrid );
+      FC::mulFeatures( features[ i ], this->m_cosineWindow );
+    }
+
+    this->m_pipeline->process( features );
+    candidates[ s ] = features;
+  }
+
+  std::vector< cv::Mat > frames_ = this->m_pipeline->modelImages( frame );
+  std::vector< std::vector< DetectResult > > results( candidates[ 0 ].size() );
+  std::vector< double > scores( scaleCount, 0.0 );
+
+  for( size_t i = 0; i < results.size(); i++ )
+  {
+    std::vector< std::shared_ptr< FC > > features( scaleCount );
+
+    for( size_t s = 0; s < scaleCount; s++ )
+    {
+      features[ s ] = candidates[ s ][ i ];
+    }
+
+    results[ i ] = this->m_targetTracker[ i ]->detectScales( frames_[ i ], features, position, cellScales,
+      this->m_depthSegmenter->getTargetDepth(), this->m_depthSegmenter->getTargetSTD() );
+
+    for( size_t s = 0; s < scaleCount; s++ )
+    {
+      scores[ s ] += results[ i ][ s ].maxResponse * ( ( first + s == current ) ? 1.0 : this->m_scalePenalty );
+    }
+  }
+
+  const size_t best = std::distance( scores.begin(), std::max_element( scores.begin(), scores.end() ) );
+
+  for( size_t i = 0; i < results.size(); i++ )
+  {
+    positions.push_back( results[ i ][ best ].position );
+    responses.push_back( results[ i ][ best ].maxResponse );
+    this->m_detectionSpectra.push_back( results[ i ][ best ].zf );
+  }
+
+  //Resizes the models and clears the detection spectra if the scale changed
+  this->m_scaleAnalyser->setScaleIndex( first + best );
+}
+
 void OcclusionHandler::visibleUpdate( const std::array< cv::Mat, 2 > & frame, const Point & position )
 {
 	//EVALUATE CHANGE OF SCALE....
@@ -156,7 +294,11 @@ void OcclusionHandler::visibleUpdate( const std::array< cv::Mat, 2 > & frame, co
 	std::vector< std::shared_ptr< FC > > features( 2 );
 	Rect window = boundingBoxFromPointSize( position, this->m_windowSize );
 
-	this->m_scaleAnalyser->update( frame[ 1 ], window );
+	//With multi-scale detection the scale follows the detection, not the depth
+	if( !this->m_multiScaleDetection )
+	{
+		this->m_scaleAnalyser->update( frame[ 1 ], window );
+	}
 
 
 	int64 tStopScaleCheck = cv::getTickCount();
@@ -165,17 +307,29 @@ void OcclusionHandler::visibleUpdate( const std::array< cv::Mat, 2 > & frame, co
 
 
 	int64 tStartModelUpdate=tStopScaleCheck;
-	window = boundingBoxFromPointSize( position, this->m_windowSize );
 
-	tbb::parallel_for< uint >( 0, 2, 1,
-		[this,&frame,&features,&window]( uint index ) -> void
+	//Move the detection spectrum to the new position instead of extracting the features again.
+	//A scale change clears the spectra, as they no longer match the model
+	const cv::Point_< double > shift = ( position - this->m_detectionPosition ) * ( 1.0 / this->m_cellSize );
+
+	if( this->m_reuseDetectionSpectrum && this->m_detectionSpectra.size() == this->m_numberOfModels &&
+		std::abs( shift.x ) <= this->m_maxSpectrumShift && std::abs( shift.y ) <= this->m_maxSpectrumShift )
 	{
-		features[ index ] = this->m_featureExtractor->getFeatures( frame[ index ], window );
-		FC::mulFeatures( features[ index ], this->m_cosineWindow );
+		for( size_t i = 0; i < this->m_detectionSpectra.size(); i++ )
+		{
+			this->m_targetTracker[ i ]->updateFromSpectrum( FC::shiftSpectrumFeatures( this->m_detectionSpectra[ i ], shift ) );
+		}
+
+		this->m_detectionSpectra.clear();
+		this->singleFrameProTime[6]=cv::getTickCount()-tStartModelUpdate;
+
+		return;
 	}
-	);
 
-	features = this->m_featureProcessor->concatenate( features );
+	this->m_detectionSpectra.clear();
+	window = boundingBoxFromPointSize( position, this->m_windowSize );
+
+	this->m_pipeline->extractProcessed( frame, window, this->m_cellSize, this->m_cosineWindow, features );
 
 	for( size_t i = 0; i < features.size(); i++ )
 	{
@@ -248,9 +402,11 @@ double OcclusionHandler::phi( const DepthHistogram & histogram, const int object
   return occluderArea / totalArea;
 }
 
-void OcclusionHandler::onScaleChange( const Size & targetSize, const Size & windowSize, const cv::Mat2d & yf, const cv::Mat1d & cosineWindow )
+void OcclusionHandler::onScaleChange( const Size & targetSize, const Size & windowSize, int cellSize, const Mat1r & yf, const Mat1r & cosineWindow )
 {
   this->m_targetSize = targetSize;
   this->m_windowSize = windowSize;
+  this->m_cellSize = cellSize;
   this->m_cosineWindow = cosineWindow;
+  this->m_detectionSpectra.clear();
 }
@@ -59,6 +59,9 @@ DS-KCF: A ~real-time tracker for RGB-D data, Journal of Real-Time Image Processi
 #include "kcf_tracker.hpp"
 #include "ScaleChangeObserver.hpp"
 #include "FeatureChannelProcessor.hpp"
+#include "FeaturePipeline.hpp"
+#include "DskcfParameters.hpp"
+#include "Redetector.hpp"
 
 /**
  * A wrapper class around a pair of trackers, one for the target object and another for the occluding object.
@@ -71,10 +74,12 @@ public:
    * @param paras The KCF tracker parameters to be used by both trackers.
    * @param kernel The kernel to be used for the correlation step in the tracker.
    * @param depthSegmenter A non-owning reference to the depth segmenter to be used by this tracker.
-   * @param featureExtractor A non-owning reference to the feature extractor to be used by this tracker.
+   * @param pipeline The feature extraction and channel processing to be used by this tracker.
+   * @param dskcfParas The run time options of the DS-KCF tracker.
    * @warning None of these parameters should be null.
    */
-  OcclusionHandler( KcfParameters paras, std::shared_ptr< Kernel > & kernel, std::shared_ptr< FeatureExtractor > & featureExtractor, std::shared_ptr< FeatureChannelProcessor > & featureProcessor );
+  OcclusionHandler( KcfParameters paras, std::shared_ptr< Kernel > & kernel, const std::shared_ptr< FeaturePipeline > & pipeline,
+    const DskcfParameters & dskcfParas = DskcfParameters() );
   virtual ~OcclusionHandler();
 
   /**
@@ -97,6 +102,23 @@ public:
 
   const float score( const std::array< cv::Mat, 2 > & frame, const Point & position );
 
+  /**
+   * Score several candidate positions on the same frame, extracting the features of all
+   * their windows in one batch, see FeaturePipeline::extractBatch.
+   *
+   * @returns The score of each position, as score would return it.
+   */
+  const std::vector< float > score( const std::array< cv::Mat, 2 > & frame, const std::vector< Point > & positions );
+
+  /**
+   * Search the whole frame for the target, see Redetector.
+   *
+   * @param frame The RGB and depth maps for the current frame.
+   *
+   * @returns The new bounding box of the target object, if it was found.
+   */
+  const boost::optional< Rect > redetect( const std::array< cv::Mat, 2 > & frame );
+
   /**
    * Update the tracker's model
    *
@@ -105,20 +127,36 @@ public:
    */
   void update( const std::array< cv::Mat, 2 > & frame, const Point & position );
 
-  virtual void onScaleChange( const Size & targetSize, const Size & windowSize, const cv::Mat2d & yf, const cv::Mat1d & cosineWindow );
+  virtual void onScaleChange( const Size & targetSize, const Size & windowSize, int cellSize, const Mat1r & yf, const Mat1r & cosineWindow );
 
   std::vector<int64> singleFrameProTime;
 
 private:
-  std::shared_ptr< FeatureChannelProcessor > m_featureProcessor;
-  std::shared_ptr< FeatureExtractor > m_featureExtractor;
+  std::shared_ptr< FeaturePipeline > m_pipeline;
   std::shared_ptr< DepthSegmenter > m_depthSegmenter;
   std::shared_ptr< ScaleAnalyser > m_scaleAnalyser;
   KcfParameters m_paras;
+  ExecutionPolicy m_executionPolicy;
+  std::shared_ptr< Redetector > m_redetector;
+  bool m_redetection;
+  double m_lossThreshold;
+  size_t m_numberOfModels;
+  bool m_reuseDetectionSpectrum;
+  double m_maxSpectrumShift;
+  bool m_multiScaleDetection;
+  double m_scalePenalty;
+  bool m_reportDftCosts;
+
+  /** The spectra of the last detection per model, and the position they were extracted at */
+  std::vector< std::shared_ptr< FC > > m_detectionSpectra;
+  Point m_detectionPosition;
   std::shared_ptr< Kernel > m_kernel;
   cv::Size_< double > m_targetSize;
   cv::Size_< double > m_initialSize;
   cv::Size_< double > m_windowSize;
+
+  /** The size of a feature cell of the current scale in pixels, shared by the extraction and the models */
+  int m_cellSize;
   cv::Size_< double > m_occluderSize;
   cv::Size_< double > m_occluderWindowSize;
   cv::Rect_< double > m_searchWindow;
@@ -144,6 +182,17 @@ private:
    */
   const boost::optional< Rect > visibleDetect( const std::array< cv::Mat, 2 > & frame, const Point & position );
 
+  /**
+   * Detect the target at the current scale and its neighbours. The features are extracted once for
+   * the largest window and resampled for the others; the best scale becomes the current scale.
+   *
+   * @param frame The RGB and depth maps for the current frame.
+   * @param position The position of the target in the previous frame.
+   * @param[out] positions The position found by every model at the best scale.
+   * @param[out] responses The maximum response of every model at the best scale.
+   */
+  void multiScaleDetect( const std::array< cv::Mat, 2 > & frame, const Point & position, std::vector< Point > & positions, std::vector< double > & responses );
+
   /**
    * Update the tracker's model
    *
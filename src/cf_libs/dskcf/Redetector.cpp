@@ -0,0 +1,151 @@
+#include "Redetector.hpp"
+
+#include <cmath>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include "math_helper.hpp"
+
+/** The number of highest responses which are weighted by their depth */
+static const size_t REDETECTION_PEAKS = 20;
+
+Redetector::Redetector( const std::shared_ptr< FeaturePipeline > & pipeline, const DskcfParameters & paras ) :
+	m_pipeline( pipeline ),
+	m_threshold( paras.redetectionThreshold ),
+	m_maxCells( paras.redetectionMaxCells ),
+	m_responseAnalyser( REDETECTION_PEAKS, false )
+{
+}
+
+boost::optional< cv::Rect_< double > > Redetector::detect( const std::array< cv::Mat, 2 > & frame, const std::vector< KcfTracker::SpatialFilter > & filters,
+	const cv::Size_< double > & targetSize, double targetDepth, double targetSTD ) const
+{
+	//Downscale the frame, and the filters with it, such that the search stays within m_maxCells feature cells
+	const int cellSize = filters[ 0 ].cellSize;
+	const double cells = static_cast< double >( frame[ 0 ].cols / cellSize ) * ( frame[ 0 ].rows / cellSize );
+	const double scale = std::max( 1.0, std::sqrt( cells / this->m_maxCells ) );
+	std::array< cv::Mat, 2 > scaledFrame = frame;
+
+	if( scale > 1.0 )
+	{
+		cv::Size size( cvRound( frame[ 0 ].cols / scale ), cvRound( frame[ 0 ].rows / scale ) );
+		cv::resize( frame[ 0 ], scaledFrame[ 0 ], size, 0, 0, cv::INTER_AREA );
+		cv::resize( frame[ 1 ], scaledFrame[ 1 ], size, 0, 0, cv::INTER_NEAREST );
+	}
+
+	std::vector< std::shared_ptr< FC > > features;
+	cv::Rect_< double > whole( 0, 0, scaledFrame[ 0 ].cols, scaledFrame[ 0 ].rows );
+
+	this->m_pipeline->extract( scaledFrame, whole, cellSize, cv::Mat(), features );
+
+	if( !features[ 0 ] || !features[ 1 ] )
+	{
+		return boost::none;
+	}
+
+	this->m_pipeline->process( features );
+	CV_Assert( features.size() == filters.size() );
+
+	cv::Mat1d score;
+
+	for( size_t i = 0; i < features.size(); i++ )
+	{
+		std::shared_ptr< FC > filter = filters[ i ].filter;
+
+		if( scale > 1.0 )
+		{
+			//INTER_AREA averages, so the values are scaled to keep the sum of the filter
+			const cv::Size size( std::max( 1, cvRound( filter->channels[ 0 ].cols / scale ) ), std::max( 1, cvRound( filter->channels[ 0 ].rows / scale ) ) );
+			std::shared_ptr< FC > scaled = std::make_shared< FC >( filter->numberOfChannels() );
+			scaled->allocate( size, filter->channels[ 0 ].type() );
+
+			for( size_t c = 0; c < filter->numberOfChannels(); c++ )
+			{
+				cv::resize( filter->channels[ c ], scaled->channels[ c ], size, 0, 0, cv::INTER_AREA );
+				scaled->channels[ c ] *= scale * scale;
+			}
+
+			filter = scaled;
+		}
+
+		const cv::Mat & grid = features[ i ]->channels[ 0 ];
+
+		if( filter->channels[ 0 ].cols > grid.cols || filter->channels[ 0 ].rows > grid.rows )
+		{
+			return boost::none;
+		}
+
+		cv::Mat response = correlate( features[ i ], filter );
+		response.convertTo( response, CV_64F, 1.0 / ( filters[ i ].peak * features.size() ) );
+
+		if( score.empty() )
+		{
+			score = response;
+		}
+		else
+		{
+			score += response;
+		}
+	}
+
+	//Weight the highest responses by the depth at the centre of their window
+	ResponseAnalysis analysis;
+	this->m_responseAnalyser.analyse( score, analysis );
+	const std::vector< ResponsePeak > & peaks = analysis.peaks;
+	const cv::Size modelSize = filters[ 0 ].filter->channels[ 0 ].size();
+	const cv::Point_< double > windowCenter( modelSize.width * cellSize / 2.0, modelSize.height * cellSize / 2.0 );
+	boost::optional< cv::Point_< double > > best;
+	double bestScore = this->m_threshold;
+
+	for( size_t i = 0; i < peaks.size(); i++ )
+	{
+		cv::Point_< double > position = cellSize * scale * pointCast< double >( peaks[ i ].position ) + windowCenter;
+		cv::Point pixel( cvRound( position.x ), cvRound( position.y ) );
+		pixel.x = std::max( 0, std::min( frame[ 1 ].cols - 1, pixel.x ) );
+		pixel.y = std::max( 0, std::min( frame[ 1 ].rows - 1, pixel.y ) );
+
+		const double weighted = peaks[ i ].value * weightDistanceLogisticOnDepth( targetDepth, frame[ 1 ].at< ushort >( pixel ), targetSTD );
+
+		if( weighted >= bestScore )
+		{
+			bestScore = weighted;
+			best = position;
+		}
+	}
+
+	if( best )
+	{
+		return boundingBoxFromPointSize( *best, targetSize );
+	}
+
+	return boost::none;
+}
+
+cv::Mat Redetector::correlate( const std::shared_ptr< FC > & features, const std::shared_ptr< FC > & filter )
+{
+	//Zero pad both to a fast DFT size; the positions where the filter wraps around are cut off below
+	const cv::Size grid = features->channels[ 0 ].size();
+	const cv::Size kernel = filter->channels[ 0 ].size();
+	const cv::Size dftSize( cv::getOptimalDFTSize( grid.width ), cv::getOptimalDFTSize( grid.height ) );
+	const int type = features->channels[ 0 ].type();
+
+	std::shared_ptr< FC > paddedFeatures = std::make_shared< FC >( features->numberOfChannels() );
+	std::shared_ptr< FC > paddedFilter = std::make_shared< FC >( filter->numberOfChannels() );
+	paddedFeatures->allocate( dftSize, type );
+	paddedFilter->allocate( dftSize, type );
+
+	for( size_t c = 0; c < features->numberOfChannels(); c++ )
+	{
+		paddedFeatures->channels[ c ].setTo( 0 );
+		paddedFilter->channels[ c ].setTo( 0 );
+		features->channels[ c ].copyTo( paddedFeatures->channels[ c ]( cv::Rect( cv::Point(), grid ) ) );
+		filter->channels[ c ].convertTo( paddedFilter->channels[ c ]( cv::Rect( cv::Point(), kernel ) ), type );
+	}
+
+	// r( p ) = sum_c sum_q w_c( q ) z_c( p + q ) = idft( sum_c zf_c .* conj( wf_c ) )
+	cv::Mat response;
+	FFTEngine::getDefault()->idft(
+		FC::mulSpectrumsSumFeatures( FC::dftFeatures( paddedFeatures ), FC::dftFeatures( paddedFilter ), true ),
+		response, cv::DFT_REAL_OUTPUT | cv::DFT_SCALE );
+
+	return response( cv::Rect( 0, 0, grid.width - kernel.width + 1, grid.height - kernel.height + 1 ) );
+}
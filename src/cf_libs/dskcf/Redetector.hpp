@@ -0,0 +1,96 @@
+#ifndef _REDETECTOR_HPP_
+#define _REDETECTOR_HPP_
+/*
+// License Agreement (3-clause BSD License)
+// Copyright (c) 2016, Jake Hall, Massimo Camplan, Sion Hannuna.
+// Third party copyrights and patents are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the names of the copyright holders nor the names of the contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall copyright holders or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+*/
+
+/*
+Redetector searches the whole frame for a lost target. The model of every
+KcfTracker is turned into a spatial filter (see KcfTracker::getSpatialFilter),
+which is correlated with the features of the entire, possibly downscaled,
+frame in a single large DFT. The highest responses are weighted by their depth
+as in DepthWeightKCFTracker, so the cost of a search only depends on the frame
+size and not on the number of probed positions.
+
+For the linear kernel the full frame response is exact; for the other kernels
+it is the response of the linear part of the model, which is sufficient to
+rank candidate positions.
+*/
+
+#include <array>
+#include <memory>
+#include <vector>
+
+#include <boost/optional.hpp>
+#include <opencv2/core/core.hpp>
+
+#include "kcf_tracker.hpp"
+#include "FeaturePipeline.hpp"
+#include "DskcfParameters.hpp"
+#include "ResponseAnalyser.hpp"
+
+class Redetector
+{
+public:
+	/**
+	 * @param pipeline The feature extraction and channel processing of the tracker.
+	 * @param paras The run time options of the DS-KCF tracker.
+	 */
+	Redetector( const std::shared_ptr< FeaturePipeline > & pipeline, const DskcfParameters & paras );
+
+	/**
+	 * Searches the whole frame for the target.
+	 *
+	 * @param frame The RGB and depth maps for the current frame.
+	 * @param filters The spatial filters of the models, one per processed feature set; the frame is searched with their cell size.
+	 * @param targetSize The size of the target in pixels.
+	 * @param targetDepth The mean depth of the target.
+	 * @param targetSTD The standard deviation of the depth of the target.
+	 *
+	 * @returns The bounding box of the best candidate, if its score reaches DskcfParameters::redetectionThreshold.
+	 */
+	boost::optional< cv::Rect_< double > > detect( const std::array< cv::Mat, 2 > & frame, const std::vector< KcfTracker::SpatialFilter > & filters,
+		const cv::Size_< double > & targetSize, double targetDepth, double targetSTD ) const;
+private:
+	std::shared_ptr< FeaturePipeline > m_pipeline;
+	double m_threshold;
+	int m_maxCells;
+
+	/** Finds the highest local maxima of a search; the score map does not wrap around, see ResponseAnalyser */
+	ResponseAnalyser m_responseAnalyser;
+
+	/**
+	 * Correlates every channel of filter with the matching channel of features over all positions
+	 * where the filter lies completely inside the features, and sums the results over the channels.
+	 */
+	static cv::Mat correlate( const std::shared_ptr< FC > & features, const std::shared_ptr< FC > & filter );
+};
+
+#endif
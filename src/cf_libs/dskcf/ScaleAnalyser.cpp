@@ -5,7 +5,7 @@
 
 typedef cv::Rect_< double > Rect;
 
-ScaleAnalyser::ScaleAnalyser( DepthSegmenter * depthSegmenter, double padding )
+ScaleAnalyser::ScaleAnalyser( DepthSegmenter * depthSegmenter, double padding, int cellSize, int maxCells, bool optimalDftSizes )
 {
 	double step = 0.1;
 
@@ -22,15 +22,19 @@ ScaleAnalyser::ScaleAnalyser( DepthSegmenter * depthSegmenter, double padding )
 	this->m_minStep = std::abs( this->m_step );
 	this->m_i = 6;
 	this->m_initialDepth = this->m_currentDepth = 1.0;
-	this->m_cellSize = 4;
+	this->m_cellSize = cellSize;
+	this->m_maxCells = maxCells;
 	this->m_outputSigmaFactor = 0.1;
 	this->m_scaleFactor = 1.0;
+	this->m_optimalDftSizes = optimalDftSizes;
 
 	//Pre-allocate all the memory we need
 	this->m_windowSizes.resize( this->m_scales.size() );
+	this->m_cellSizes.resize( this->m_scales.size() );
 	this->m_targetSizes.resize( this->m_scales.size() );
 	this->m_targetPositions.resize( this->m_scales.size() );
 	this->m_outputSigmas.resize( this->m_scales.size() );
+	this->m_dftCosts.resize( this->m_scales.size() );
 	this->m_yfs.resize( this->m_scales.size() );
 	this->m_cosineWindows.resize( this->m_scales.size() );
 }
@@ -52,13 +56,17 @@ ScaleAnalyser::ScaleAnalyser( const std::vector< double > & scales, const double
 	this->m_minStep = this->m_step;
 	this->m_initialDepth = this->m_currentDepth = 1.0;
 	this->m_cellSize = cellSize;
+	this->m_maxCells = 0;
 	this->m_outputSigmaFactor = outputSigmaFactor;
 	this->m_scaleFactor = 1.0;
+	this->m_optimalDftSizes = false;
 
 	this->m_windowSizes.resize( scales.size() );
+	this->m_cellSizes.resize( scales.size() );
 	this->m_targetSizes.resize( scales.size() );
 	this->m_targetPositions.resize( scales.size() );
 	this->m_outputSigmas.resize( scales.size() );
+	this->m_dftCosts.resize( scales.size() );
 	this->m_yfs.resize( scales.size() );
 	this->m_cosineWindows.resize( scales.size() );
 }
@@ -77,19 +85,30 @@ Rect ScaleAnalyser::init( const cv::Mat &, const Rect & boundingBox )
 			this->m_targetSizes[ i ] = sizeRound( boundingBox.size() * ( this->m_scales[ i ] ) );
 			this->m_windowSizes[ i ] = sizeRound( this->m_targetSizes[ i ] * this->m_padding );
 
-			this->m_outputSigmas[ i ] = sqrt( this->m_targetSizes[ i ].area() ) * this->m_outputSigmaFactor / this->m_cellSize;
+			// Larger scales get larger cells, so the cost of a frame stays bounded however close the target gets
+			const int cellSize = this->fittingCellSize( this->m_windowSizes[ i ] );
+			this->m_cellSizes[ i ] = cellSize;
+
+			if( this->m_optimalDftSizes )
+			{
+				this->m_windowSizes[ i ] = this->optimalWindowSize( this->m_windowSizes[ i ], cellSize );
+			}
+
+			this->m_outputSigmas[ i ] = sqrt( this->m_targetSizes[ i ].area() ) * this->m_outputSigmaFactor / cellSize;
 
-			cv::dft(
-				gaussianShapedLabelsShifted2D(
-					this->m_outputSigmas[ i ],
-					sizeFloor( this->m_windowSizes[ i ] * ( 1.0 / static_cast< double >( this->m_cellSize ) ) )
-				),
-				this->m_yfs[ i ], cv::DFT_COMPLEX_OUTPUT
+			cv::Mat labels = gaussianShapedLabelsShifted2D< Real >(
+				static_cast< Real >( this->m_outputSigmas[ i ] ),
+				cv::Size_< Real >( sizeFloor( this->m_windowSizes[ i ] * ( 1.0 / static_cast< double >( cellSize ) ) ) )
 			);
 
+			// Set up the transforms of every scale now rather than on the first frame which uses it
+			FFTEngine::getDefault()->prepare( labels.size(), labels.type() );
+			this->m_dftCosts[ i ] = dftCost( labels.size() );
+			FFTEngine::getDefault()->dft( labels, this->m_yfs[ i ] );
+
 			this->m_cosineWindows[ i ] =
-				hanningWindow< double >( this->m_yfs[ i ].rows ) *
-				hanningWindow< double >( this->m_yfs[ i ].cols ).t();
+				hanningWindow< Real >( this->m_yfs[ i ].rows ) *
+				hanningWindow< Real >( this->m_yfs[ i ].cols ).t();
 
 			if( this->m_scales[ i ] == 1.0 )
 			{
@@ -97,15 +116,7 @@ Rect ScaleAnalyser::init( const cv::Mat &, const Rect & boundingBox )
 			}
 		}
 
-		for( auto itr = this->m_observers.begin(); itr != this->m_observers.end(); itr++ )
-		{
-			(*itr)->onScaleChange(
-				this->m_targetSizes[ this->m_i ],
-				this->m_windowSizes[ this->m_i ],
-				this->m_yfs[ this->m_i ],
-				this->m_cosineWindows[ this->m_i ]
-			);
-		}
+		this->notifyObservers();
 	}
 
 	return boundingBox;
@@ -154,16 +165,7 @@ Rect ScaleAnalyser::update( const cv::Mat & image, const Rect & boundingBox )
 			if( this->m_i != ind )
 			{
 				this->m_i = ind;
-
-				for( auto itr = this->m_observers.begin(); itr != this->m_observers.end(); itr++ )
-				{
-					(*itr)->onScaleChange(
-						this->m_targetSizes[ this->m_i ],
-						this->m_windowSizes[ this->m_i ],
-						this->m_yfs[ this->m_i ],
-						this->m_cosineWindows[ this->m_i ]
-					);
-				}
+				this->notifyObservers();
 			}
 		}
 		else if( ( scaleOffset > 0 ) && ( this->m_i < this->m_scales.size() ) )
@@ -194,14 +196,7 @@ Rect ScaleAnalyser::update( const cv::Mat & image, const Rect & boundingBox )
 			if( this->m_i != ind )
 			{
 				this->m_i = ind;
-
-				for( auto itr = this->m_observers.begin(); itr != this->m_observers.end(); itr++ )
-				{
-					(*itr)->onScaleChange(
-						this->m_targetSizes[ this->m_i ], this->m_windowSizes[ this->m_i ],
-						this->m_yfs[ this->m_i ], this->m_cosineWindows[ this->m_i ]
-					);
-				}
+				this->notifyObservers();
 			}
 		}
 	}
@@ -209,7 +204,7 @@ Rect ScaleAnalyser::update( const cv::Mat & image, const Rect & boundingBox )
 	return boundingBox;
 }
 
-cv::Mat2d ScaleAnalyser::scaleImageFourier( const cv::Mat2d & image_f, const cv::Size2i & size )
+Mat2r ScaleAnalyser::scaleImageFourier( const Mat2r & image_f, const cv::Size2i & size )
 {
 	if(
 		( image_f.size().width != size.width ) ||
@@ -293,18 +288,132 @@ cv::Mat2d ScaleAnalyser::scaleImageFourier( const cv::Mat2d & image_f, const cv:
 	}
 }
 
-cv::Mat2d ScaleAnalyser::scaleImageFourierShift( const cv::Mat2d & image, const cv::Size2i & size )
+Mat2r ScaleAnalyser::scaleImageFourierShift( const Mat2r & image, const cv::Size2i & size )
 {
 	return ifftshift(
 		ScaleAnalyser::scaleImageFourier( fftshift( image ), size )
 	);
 }
 
+Mat1r ScaleAnalyser::scaleImageFourierShiftCcs( const Mat1r & image, const cv::Size2i & size )
+{
+	if( image.size() == size )
+	{
+		return image;
+	}
+
+	std::shared_ptr< FFTEngine > engine = FFTEngine::getDefault();
+	Mat1r spatial, result;
+	Mat2r spectrum;
+
+	engine->idft( image, spatial, cv::DFT_REAL_OUTPUT | cv::DFT_SCALE );
+	engine->dft( spatial, spectrum, cv::DFT_COMPLEX_OUTPUT );
+	spectrum = ScaleAnalyser::scaleImageFourierShift( spectrum, size );
+	engine->idft( spectrum, spatial, cv::DFT_REAL_OUTPUT | cv::DFT_SCALE );
+	engine->dft( spatial, result );
+
+	return result;
+}
+
 double ScaleAnalyser::getScaleFactor() const
 {
 	return this->m_scaleFactor;
 }
 
+void ScaleAnalyser::printDftCosts( std::ostream & stream ) const
+{
+	stream << "Scale,Width,Height,CellSize,DftCost" << std::endl;
+
+	for( size_t i = 0; i < this->m_scales.size(); i++ )
+	{
+		stream << this->m_scales[ i ] << "," << this->m_yfs[ i ].cols << "," << this->m_yfs[ i ].rows << ","
+			<< this->m_cellSizes[ i ] << "," << this->m_dftCosts[ i ] << std::endl;
+	}
+}
+
+size_t ScaleAnalyser::getScaleIndex() const
+{
+	return this->m_i;
+}
+
+size_t ScaleAnalyser::getScaleCount() const
+{
+	return this->m_scales.size();
+}
+
+const cv::Size_< double > & ScaleAnalyser::getWindowSize( const size_t index ) const
+{
+	return this->m_windowSizes[ index ];
+}
+
+int ScaleAnalyser::getCellSize( const size_t index ) const
+{
+	return this->m_cellSizes[ index ];
+}
+
+void ScaleAnalyser::setScaleIndex( const size_t index )
+{
+	CV_Assert( index < this->m_scales.size() );
+
+	// Keep the reported scale factor in line with the model, as the depth did not pick this scale
+	this->m_scaleFactor = this->m_scales[ index ];
+
+	if( this->m_i != index )
+	{
+		this->m_i = index;
+		this->notifyObservers();
+	}
+}
+
+void ScaleAnalyser::notifyObservers()
+{
+	for( auto itr = this->m_observers.begin(); itr != this->m_observers.end(); itr++ )
+	{
+		(*itr)->onScaleChange(
+			this->m_targetSizes[ this->m_i ],
+			this->m_windowSizes[ this->m_i ],
+			this->m_cellSizes[ this->m_i ],
+			this->m_yfs[ this->m_i ],
+			this->m_cosineWindows[ this->m_i ]
+		);
+	}
+}
+
+cv::Size_< double > ScaleAnalyser::optimalWindowSize( const cv::Size_< double > & windowSize, const int cellSize ) const
+{
+	// The labels, the cosine window and the features are all sized floor( window / cell ),
+	// so a window of exactly grid * cell pixels gives the snapped grid everywhere
+	cv::Size2i grid = sizeFloor( windowSize * ( 1.0 / static_cast< double >( cellSize ) ) );
+
+	grid.width = cv::getOptimalDFTSize( std::max( grid.width, 1 ) );
+	grid.height = cv::getOptimalDFTSize( std::max( grid.height, 1 ) );
+
+	return cv::Size_< double >( grid.width * cellSize, grid.height * cellSize );
+}
+
+int ScaleAnalyser::fittingCellSize( const cv::Size_< double > & windowSize ) const
+{
+	int cellSize = this->m_cellSize;
+
+	if( this->m_maxCells > 0 )
+	{
+		// Measured on the grid the scale ends up with, which optimalWindowSize may have grown
+		while( true )
+		{
+			const cv::Size_< double > grownSize = this->m_optimalDftSizes ? this->optimalWindowSize( windowSize, cellSize ) : windowSize;
+
+			if( sizeFloor( grownSize * ( 1.0 / static_cast< double >( cellSize ) ) ).area() <= this->m_maxCells )
+			{
+				break;
+			}
+
+			cellSize++;
+		}
+	}
+
+	return cellSize;
+}
+
 void ScaleAnalyser::registerScaleChangeObserver( ScaleChangeObserver * observer )
 {
 	this->m_observers.push_back( observer );
@@ -322,7 +431,7 @@ std::vector< std::shared_ptr< KcfTracker > > ScaleAnalyser::createModelScales( s
 	for( size_t i = 0; i < this->m_targetSizes.size(); i++ )
 	{
 		result[ i ] = tracker->duplicate();
-		result[ i ]->onScaleChange( this->m_targetSizes[ i ], this->m_windowSizes[ i ], this->m_yfs[ i ], this->m_cosineWindows[ i ] );
+		result[ i ]->onScaleChange( this->m_targetSizes[ i ], this->m_windowSizes[ i ], this->m_cellSizes[ i ], this->m_yfs[ i ], this->m_cosineWindows[ i ] );
 	}
 
 	return result;
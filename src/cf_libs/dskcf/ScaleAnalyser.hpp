@@ -42,6 +42,7 @@ DS-KCF: A ~real-time tracker for RGB-D data, Journal of Real-Time Image Processi
 
 #include <array>
 #include <memory>
+#include <ostream>
 #include <opencv2/highgui/highgui.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
 #include <opencv2/core/traits.hpp>
@@ -60,7 +61,16 @@ class KcfTracker;
 class ScaleAnalyser
 {
 public:
-	ScaleAnalyser( DepthSegmenter * depthSegmenter, double padding );
+	/**
+	 * @param depthSegmenter The depth segmenter providing the target depth.
+	 * @param padding The size of the window around the target, relative to the target size.
+	 * @param cellSize The size of a feature cell in pixels, the smallest cell size of any scale.
+	 * @param maxCells The largest feature grid of a scale; the cell size of a scale whose window
+	 *   would exceed it grows until it fits. 0 keeps cellSize for every scale.
+	 * @param optimalDftSizes If true, the feature grid of every scale is grown to the next size
+	 *   which only has 2, 3 and 5 as prime factors, see cv::getOptimalDFTSize.
+	 */
+	ScaleAnalyser( DepthSegmenter * depthSegmenter, double padding, int cellSize, int maxCells = 0, bool optimalDftSizes = false );
 	ScaleAnalyser( const std::vector< double > & scales, const double outputSigmaFactor, const int cellSize, double padding );
 
 	cv::Rect_< double > init( const cv::Mat & image, const cv::Rect_< double > & boundingBox );
@@ -68,16 +78,58 @@ public:
 
 	double getScaleFactor() const;
 
+	/**
+	 * @returns The index of the current scale.
+	 */
+	size_t getScaleIndex() const;
+
+	/**
+	 * @returns The number of scales.
+	 */
+	size_t getScaleCount() const;
+
+	/**
+	 * @returns The padded window size of the scale at index.
+	 */
+	const cv::Size_< double > & getWindowSize( const size_t index ) const;
+
+	/**
+	 * @returns The size of a feature cell of the scale at index in pixels.
+	 */
+	int getCellSize( const size_t index ) const;
+
+	/**
+	 * Switches to the scale at index without consulting the depth, e.g. after a multi-scale
+	 * detection found the target at a neighbouring scale. The observers are notified if the
+	 * scale changed.
+	 */
+	void setScaleIndex( const size_t index );
+
+	/**
+	 * Prints the feature grid, the cell size and the estimated relative cost of one DFT
+	 * (see dftCost) of every scale, one line per scale.
+	 */
+	void printDftCosts( std::ostream & stream ) const;
+
 	void registerScaleChangeObserver( ScaleChangeObserver * observer );
 	void clearObservers();
 
 	std::vector< std::shared_ptr< KcfTracker > > createModelScales( std::shared_ptr< KcfTracker > tracker );
 
-	static cv::Mat2d scaleImageFourier( const cv::Mat2d & image, const cv::Size2i & size );
-	static cv::Mat2d scaleImageFourierShift( const cv::Mat2d & image, const cv::Size2i & size );
+	static Mat2r scaleImageFourier( const Mat2r & image, const cv::Size2i & size );
+	static Mat2r scaleImageFourierShift( const Mat2r & image, const cv::Size2i & size );
+
+	/**
+	 * Rescales a CCS packed spectrum in the same way as scaleImageFourierShift.
+	 * The spectrum is unpacked through the spatial domain, so this is only meant
+	 * for the infrequent model rescaling.
+	 */
+	static Mat1r scaleImageFourierShiftCcs( const Mat1r & image, const cv::Size2i & size );
 private:
 	size_t m_i;
 	int m_cellSize;
+	int m_maxCells;
+	bool m_optimalDftSizes;
 	double m_padding;
 	double m_outputSigmaFactor;
 	double m_minStep;
@@ -90,12 +142,23 @@ private:
 
 	std::vector< double > m_scales;
 	std::vector< cv::Size_< double > > m_windowSizes;
+	std::vector< int > m_cellSizes;
 	std::vector< cv::Size_< double > > m_targetSizes;
 	std::vector< cv::Point_< double > > m_targetPositions;
 	std::vector< double > m_outputSigmas;
-	std::vector< cv::Mat2d > m_yfs;
-	std::vector< cv::Mat1d > m_cosineWindows;
+	std::vector< double > m_dftCosts;
+	std::vector< Mat1r > m_yfs;
+	std::vector< Mat1r > m_cosineWindows;
 	std::vector< ScaleChangeObserver* > m_observers;
+
+	cv::Size_< double > optimalWindowSize( const cv::Size_< double > & windowSize, const int cellSize ) const;
+
+	/**
+	 * @returns The smallest cell size, starting at m_cellSize, for which the grid of windowSize has at most m_maxCells cells,
+	 *   after it has been grown to a fast DFT size if m_optimalDftSizes is set.
+	 */
+	int fittingCellSize( const cv::Size_< double > & windowSize ) const;
+	void notifyObservers();
 };
 
 #endif
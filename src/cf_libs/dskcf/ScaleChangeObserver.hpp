@@ -55,13 +55,14 @@ public:
 	 * onScaleChange is called whenever a scale change has been detected.
 	 * @param targetSize The new size of the target object's bounding box.
 	 * @param windowSize The new padded size of the bounding box around the target.
-	 * @param yf The new gaussian shaped labels for this scale.
+	 * @param cellSize The size of a feature cell of this scale in pixels, see ScaleAnalyser.
+	 * @param yf The CCS packed spectrum of the new gaussian shaped labels for this scale.
 	 * @param cosineWindow The new cosine window for this scale.
 	 *
 	 * @warning If an instance of this class is registered to observe multiple
 	 *   ScaleAnalyser, then this method will likely cause a crash.
 	 */
-	virtual void onScaleChange( const Size & targetSize, const Size & windowSize, const cv::Mat2d & yf, const cv::Mat1d & cosineWindow ) = 0;
+	virtual void onScaleChange( const Size & targetSize, const Size & windowSize, int cellSize, const Mat1r & yf, const Mat1r & cosineWindow ) = 0;
 };
 
 #endif
@@ -1,18 +1,21 @@
 #include "dskcf_tracker.hpp"
 
+#include <stdexcept>
+
 #include "GaussianKernel.hpp"
+#include "LinearKernel.hpp"
+#include "PolynomialKernel.hpp"
 #include "HOGFeatureExtractor.hpp"
+#include "RawFeatureExtractor.hpp"
 #include "ConcatenateFeatureChannelProcessor.h"
+#include "ColourFeatureChannelProcessor.h"
+#include "DepthFeatureChannelProcessor.h"
+#include "LinearFeatureChannelProcessor.h"
 
-typedef cv::Rect_< double > Rect;
-
-DskcfTracker::DskcfTracker()
+DskcfTracker::DskcfTracker( const DskcfParameters & paras ) : m_paras( paras )
 {
-	std::shared_ptr< Kernel > kernel = std::make_shared< GaussianKernel >();
-	std::shared_ptr< FeatureExtractor > features = std::make_shared< HOGFeatureExtractor >();
-	std::shared_ptr< FeatureChannelProcessor > processor = std::make_shared< ConcatenateFeatureChannelProcessor >();
-
-	this->m_occlusionHandler = std::make_shared< OcclusionHandler >(KcfParameters(), kernel, features, processor);
+	this->m_arena = this->m_paras.execution.createArena();
+	this->m_occlusionHandler = this->createOcclusionHandler();
 }
 
 DskcfTracker::~DskcfTracker()
@@ -22,42 +25,161 @@ DskcfTracker::~DskcfTracker()
 float DskcfTracker::detect( const std::array< cv::Mat, 2 > & frame, cv::Rect_< double > & boundingBox )
 {
 	Point position = centerPoint( boundingBox );
+	float result = 0.0f;
+
+	this->execute( [this, &frame, &position, &result]() -> void
+	{
+		result = this->m_occlusionHandler->score( frame, position );
+	} );
+
+	return result;
+}
+
+std::vector< float > DskcfTracker::detect( const std::array< cv::Mat, 2 > & frame,
+	const std::vector< cv::Rect_< double > > & boundingBoxes )
+{
+	std::vector< Point > positions;
+	std::vector< float > result;
+
+	for( const cv::Rect_< double > & boundingBox : boundingBoxes )
+	{
+		positions.push_back( centerPoint( boundingBox ) );
+	}
+
+	this->execute( [this, &frame, &positions, &result]() -> void
+	{
+		result = this->m_occlusionHandler->score( frame, positions );
+	} );
 
-	return this->m_occlusionHandler->score( frame, position );
+	return result;
 }
 
-bool DskcfTracker::update(const std::array< cv::Mat, 2 > & frame, Rect & boundingBox)
+bool DskcfTracker::update( const std::array< cv::Mat, 2 > & frame, cv::Rect_< double > & boundingBox )
 {
 	Point position = centerPoint( boundingBox );
+	bool result = false;
+
+	this->execute( [this, &frame, &boundingBox, &position, &result]() -> void
+	{
+		if( auto bb = this->m_occlusionHandler->detect( frame, position ) )
+		{
+			boundingBox = *bb;
+			position = centerPoint( boundingBox );
+			this->m_occlusionHandler->update( frame, position );
+
+			result = static_cast< bool >( bb );
+		}
+		else if( this->m_paras.redetection )
+		{
+			if( auto found = this->m_occlusionHandler->redetect( frame ) )
+			{
+				boundingBox = *found;
+				result = true;
+			}
+		}
+	} );
+
+	return result;
+}
+
+bool DskcfTracker::reinit( const std::array< cv::Mat, 2 > & frame, cv::Rect_< double > & boundingBox )
+{
+	this->m_occlusionHandler = this->createOcclusionHandler();
+
+	this->execute( [this, &frame, &boundingBox]() -> void
+	{
+		this->m_occlusionHandler->init(frame, boundingBox);
+	} );
+
+	return true;
+}
+
+bool DskcfTracker::redetect( const std::array< cv::Mat, 2 > & frame, cv::Rect_< double > & boundingBox )
+{
+	boost::optional< cv::Rect_< double > > found;
+
+	this->execute( [this, &frame, &found]() -> void
+	{
+		found = this->m_occlusionHandler->redetect( frame );
+	} );
 
-	if( auto bb = this->m_occlusionHandler->detect( frame, position ) )
+	if( found )
 	{
-		boundingBox = *bb;
-		position = centerPoint( boundingBox );
-		this->m_occlusionHandler->update( frame, position );
+		boundingBox = *found;
+	}
+
+	return static_cast< bool >( found );
+}
+
+std::shared_ptr< OcclusionHandler > DskcfTracker::createOcclusionHandler() const
+{
+	std::shared_ptr< Kernel > kernel = this->createKernel();
+	KcfParameters kcfParas;
+	kcfParas.cellSize = this->m_paras.cellSize;
+	kcfParas.projectedChannels = this->m_paras.projectedChannels;
+
+	auto pipeline = std::make_shared< FeaturePipeline >( this->createFeatureExtractor(), this->createProcessor() );
+
+	return std::make_shared< OcclusionHandler >( kcfParas, kernel, pipeline, this->m_paras );
+}
 
-		return static_cast< bool >( bb );
+std::shared_ptr< Kernel > DskcfTracker::createKernel() const
+{
+	if( this->m_paras.kernel == "gaussian" )
+	{
+		return std::make_shared< GaussianKernel >( this->m_paras.fourierKernelSum );
 	}
-	else
+	else if( this->m_paras.kernel == "linear" )
 	{
-		return static_cast< bool >( bb );
+		return std::make_shared< LinearKernel >();
+	}
+	else if( this->m_paras.kernel == "polynomial" )
+	{
+		return std::make_shared< PolynomialKernel >();
 	}
 
-	//return !this->m_occlusionHandler->isOccluded();
-	//return true;
+	throw std::invalid_argument( "DskcfTracker : unknown kernel " + this->m_paras.kernel );
 }
 
-bool DskcfTracker::reinit(const std::array< cv::Mat, 2 > & frame, Rect & boundingBox)
+std::shared_ptr< FeatureExtractor > DskcfTracker::createFeatureExtractor() const
 {
-	std::shared_ptr< Kernel > kernel = std::make_shared< GaussianKernel >();
-	std::shared_ptr< FeatureExtractor > features = std::make_shared< HOGFeatureExtractor >();
-	std::shared_ptr< FeatureChannelProcessor > processor = std::make_shared< ConcatenateFeatureChannelProcessor >();
+	if( this->m_paras.features == "hog" )
+	{
+		if( this->m_paras.denseFeatures )
+		{
+			return this->m_paras.denseFeatures;
+		}
+
+		return std::make_shared< HOGFeatureExtractor >();
+	}
+	else if( this->m_paras.features == "raw" )
+	{
+		return std::make_shared< RawFeatureExtractor >();
+	}
 
-	this->m_occlusionHandler = std::make_shared< OcclusionHandler >(KcfParameters(), kernel, features, processor);
+	throw std::invalid_argument( "DskcfTracker : unknown features " + this->m_paras.features );
+}
 
-	this->m_occlusionHandler->init(frame, boundingBox);
+std::shared_ptr< FeatureChannelProcessor > DskcfTracker::createProcessor() const
+{
+	if( this->m_paras.channels == "concatenate" )
+	{
+		return std::make_shared< ConcatenateFeatureChannelProcessor >();
+	}
+	else if( this->m_paras.channels == "colour" )
+	{
+		return std::make_shared< ColourFeatureChannelProcessor >();
+	}
+	else if( this->m_paras.channels == "depth" )
+	{
+		return std::make_shared< DepthFeatureChannelProcessor >();
+	}
+	else if( this->m_paras.channels == "linear" )
+	{
+		return std::make_shared< LinearFeatureChannelProcessor >();
+	}
 
-	return true;
+	throw std::invalid_argument( "DskcfTracker : unknown channel processing " + this->m_paras.channels );
 }
 
 TrackerDebug* DskcfTracker::getTrackerDebug()
@@ -33,6 +33,7 @@
 
 
 #include <array>
+#include <memory>
 #include <opencv2/imgproc/imgproc.hpp>
 #include <opencv2/core/traits.hpp>
 #include <opencv2/core/core.hpp>
@@ -43,8 +44,11 @@
 #include "DepthSegmenter.hpp"
 #include "ScaleAnalyser.hpp"
 #include "FeatureExtractor.hpp"
+#include "FeaturePipeline.hpp"
 #include "OcclusionHandler.hpp"
 #include "ScaleChangeObserver.hpp"
+#include "DskcfParameters.hpp"
+#include "DenseHOGFeatureExtractor.hpp"
 
 /**
  * DskcfTracker implements a depth scaling kernelised correlation filter as
@@ -56,15 +60,81 @@
 class DskcfTracker : public CfTracker
 {
 public:
-	DskcfTracker();
+	DskcfTracker( const DskcfParameters & paras = DskcfParameters() );
 	virtual ~DskcfTracker();
 	float detect( const std::array< cv::Mat, 2 > & frame, cv::Rect_< double > & boundingBox );
+
+	/**
+	 * Scores several bounding boxes on the same frame as detect does, extracting
+	 * the features of all of them in one batch.
+	 *
+	 * @returns The score of each bounding box.
+	 */
+	std::vector< float > detect( const std::array< cv::Mat, 2 > & frame, const std::vector< cv::Rect_< double > > & boundingBoxes );
 	virtual bool update(const std::array< cv::Mat, 2 > & frame, cv::Rect_< double > & boundingBox);
 	virtual bool reinit(const std::array< cv::Mat, 2 > & frame, cv::Rect_< double > & boundingBox);
 
+	/**
+	 * Searches the whole frame for the target, see Redetector. The model is not updated.
+	 *
+	 * @param frame The RGB and depth maps for the current frame.
+	 * @param[out] boundingBox The bounding box of the target, if it was found.
+	 *
+	 * @returns True if the target was found.
+	 */
+	bool redetect( const std::array< cv::Mat, 2 > & frame, cv::Rect_< double > & boundingBox );
+
 	virtual TrackerDebug* getTrackerDebug();
 	virtual const std::string getId();
 private:
+	/**
+	 * Creates a new occlusion handler from the components selected by the parameters.
+	 */
+	std::shared_ptr< OcclusionHandler > createOcclusionHandler() const;
+
+	/**
+	 * Creates the kernel named by DskcfParameters::kernel.
+	 *
+	 * @throws std::invalid_argument If the kernel name is unknown.
+	 */
+	std::shared_ptr< Kernel > createKernel() const;
+
+	/**
+	 * Creates the feature extractor named by DskcfParameters::features; HOG features
+	 * are cropped from the shared whole frame maps if DskcfParameters::denseFeatures is set.
+	 *
+	 * @throws std::invalid_argument If the feature name is unknown.
+	 */
+	std::shared_ptr< FeatureExtractor > createFeatureExtractor() const;
+
+	/**
+	 * Creates the feature channel processor named by DskcfParameters::channels.
+	 *
+	 * @throws std::invalid_argument If the channel processing name is unknown.
+	 */
+	std::shared_ptr< FeatureChannelProcessor > createProcessor() const;
+
+	/**
+	 * Runs function in the task arena of this tracker, if it has one.
+	 */
+	template< typename Function >
+	void execute( const Function & function )
+	{
+		if( this->m_arena )
+		{
+			this->m_arena->execute( function );
+		}
+		else
+		{
+			function();
+		}
+	}
+
+	/** The run time options of the tracker */
+	DskcfParameters m_paras;
+
+	/** The task arena all work of this tracker is run in, or nullptr to use the global TBB pool */
+	std::shared_ptr< tbb::task_arena > m_arena;
 
 	/** The occlusion handler associated with this object */
 	std::shared_ptr< OcclusionHandler > m_occlusionHandler;
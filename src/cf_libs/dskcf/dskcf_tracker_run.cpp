@@ -1,6 +1,10 @@
 #include "dskcf_tracker_run.hpp"
 #include "dskcf_tracker.hpp"
 
+#include <string>
+#include <tuple>
+#include <vector>
+
 DskcfTrackerRun::DskcfTrackerRun() : TrackerRun( "DSKCF" )
 {
 }
@@ -11,16 +15,99 @@ DskcfTrackerRun::~DskcfTrackerRun()
 
 CfTracker * DskcfTrackerRun::parseTrackerParas(TCLAP::CmdLine& cmd, int argc, const char** argv)
 {
-	TCLAP::SwitchArg rawDepth( "", "raw_depth", "", cmd, false );
-	TCLAP::SwitchArg rawColour( "", "raw_colour", "", cmd, false );
-	TCLAP::SwitchArg rawConcatenate( "", "raw_concatenate", "", cmd, false );
-	TCLAP::SwitchArg rawLinear( "", "raw_linear", "", cmd, false );
-	TCLAP::SwitchArg hogColour( "", "hog_colour", "", cmd, false );
-	TCLAP::SwitchArg hogDepth( "", "hog_depth", "", cmd, false );
-	TCLAP::SwitchArg hogConcatenate( "", "hog_concatenate", "", cmd, true );
-	TCLAP::SwitchArg hogLinear( "", "hog_linear", "", cmd, false );
+	TCLAP::SwitchArg rawDepth( "", "raw_depth", "Track the cell averaged depth only", cmd, false );
+	TCLAP::SwitchArg rawColour( "", "raw_colour", "Track the cell averaged intensity only", cmd, false );
+	TCLAP::SwitchArg rawConcatenate( "", "raw_concatenate", "Track the cell averaged intensity and depth in one model", cmd, false );
+	TCLAP::SwitchArg rawLinear( "", "raw_linear", "Track the cell averaged intensity and depth in two models", cmd, false );
+	TCLAP::SwitchArg hogColour( "", "hog_colour", "Track the HOG features of the colour map only", cmd, false );
+	TCLAP::SwitchArg hogDepth( "", "hog_depth", "Track the HOG features of the depth map only", cmd, false );
+	TCLAP::SwitchArg hogConcatenate( "", "hog_concatenate",
+		"Track the HOG features of both maps in one model, the default if no other feature set is given", cmd, false );
+	TCLAP::SwitchArg hogLinear( "", "hog_linear", "Track the HOG features of both maps in two models", cmd, false );
+	std::vector< std::string > kernels = { "gaussian", "linear", "polynomial" };
+	TCLAP::ValuesConstraint< std::string > kernelConstraint( kernels );
+	TCLAP::ValueArg< std::string > kernel( "", "kernel", "The kernel of the correlation filters", false, "gaussian", &kernelConstraint, cmd );
+	TCLAP::ValueArg< int > projectedChannels( "", "projected_channels",
+		"Compress the features of every model to this many channels with an online PCA (0 keeps all channels)", false, 0, "int", cmd );
+	TCLAP::ValueArg< int > cellSize( "", "cell_size", "The size of a feature cell in pixels", false, 4, "int", cmd );
+	TCLAP::ValueArg< int > maxModelCells( "", "max_model_cells",
+		"Grow the feature cells of large targets until a model has at most this many cells (0 keeps the cell size)", false, 0, "int", cmd );
+	TCLAP::SwitchArg spatialKernelSum( "", "spatial_kernel_sum",
+		"Sum the kernel correlation over the channels in the spatial domain (one inverse DFT per channel)", cmd, false );
+	TCLAP::SwitchArg optimalDftSizes( "", "optimal_dft_sizes",
+		"Grow the model of every scale to a size with a fast DFT (only 2, 3 and 5 as prime factors)", cmd, false );
+	TCLAP::SwitchArg reportDftCosts( "", "report_dft_costs",
+		"Print the feature grid and estimated DFT cost of every scale when the tracker is initialised", cmd, false );
+	TCLAP::SwitchArg reuseDetectionSpectrum( "", "reuse_detection_spectrum",
+		"Train on the detection spectrum shifted to the new position instead of extracting the features again", cmd, false );
+	TCLAP::SwitchArg redetection( "", "redetection",
+		"Search the whole frame for the target once its response drops below the loss threshold", cmd, false );
+	TCLAP::SwitchArg multiScaleDetection( "", "multi_scale_detection",
+		"Detect at the current scale and its neighbours in one batch instead of following the target depth", cmd, false );
+	TCLAP::ValueArg< int > arenaThreads( "", "arena_threads",
+		"Run the tracker in a TBB task arena with this many threads (0 uses the global pool)", false, 0, "int", cmd );
+	TCLAP::SwitchArg sequentialInnerLoops( "", "sequential_inner_loops",
+		"Run the per channel, per bin and per frame loops of the tracker sequentially", cmd, false );
+	TCLAP::ValueArg< int > openCvThreads( "", "opencv_threads",
+		"The number of threads OpenCV may use (-1 keeps OpenCV's default)", false, -1, "int", cmd );
 
 	cmd.parse( argc, argv );
 
-	return new DskcfTracker( );
+	DskcfParameters paras;
+
+	//Without a selection DskcfParameters keeps HOG features concatenated in one model
+	const std::vector< std::tuple< TCLAP::SwitchArg *, std::string, std::string > > featureSets = {
+		std::make_tuple( &rawDepth, "raw", "depth" ),
+		std::make_tuple( &rawColour, "raw", "colour" ),
+		std::make_tuple( &rawConcatenate, "raw", "concatenate" ),
+		std::make_tuple( &rawLinear, "raw", "linear" ),
+		std::make_tuple( &hogColour, "hog", "colour" ),
+		std::make_tuple( &hogDepth, "hog", "depth" ),
+		std::make_tuple( &hogConcatenate, "hog", "concatenate" ),
+		std::make_tuple( &hogLinear, "hog", "linear" )
+	};
+	int selectedFeatureSets = 0;
+
+	for( const auto & featureSet : featureSets )
+	{
+		if( std::get< 0 >( featureSet )->getValue() )
+		{
+			paras.features = std::get< 1 >( featureSet );
+			paras.channels = std::get< 2 >( featureSet );
+			selectedFeatureSets++;
+		}
+	}
+
+	if( selectedFeatureSets > 1 )
+	{
+		throw TCLAP::CmdLineParseException( "only one of the raw_* and hog_* feature sets can be selected" );
+	}
+
+	if( cellSize.getValue() < 1 )
+	{
+		throw TCLAP::CmdLineParseException( "the cell size must be at least 1", cellSize.toString() );
+	}
+
+	if( maxModelCells.getValue() < 0 )
+	{
+		throw TCLAP::CmdLineParseException( "the cell budget must not be negative", maxModelCells.toString() );
+	}
+
+	paras.kernel = kernel.getValue();
+	paras.projectedChannels = projectedChannels.getValue();
+	paras.cellSize = cellSize.getValue();
+	paras.maxModelCells = maxModelCells.getValue();
+	paras.fourierKernelSum = !spatialKernelSum.getValue();
+	paras.optimalDftSizes = optimalDftSizes.getValue();
+	paras.reportDftCosts = reportDftCosts.getValue();
+	paras.reuseDetectionSpectrum = reuseDetectionSpectrum.getValue();
+	paras.redetection = redetection.getValue();
+	paras.multiScaleDetection = multiScaleDetection.getValue();
+
+	paras.execution.arenaConcurrency = arenaThreads.getValue();
+	paras.execution.sequentialInnerLoops = sequentialInnerLoops.getValue();
+	paras.execution.openCvThreads = openCvThreads.getValue();
+	paras.execution.applyOpenCvThreads();
+
+	return new DskcfTracker( paras );
 }
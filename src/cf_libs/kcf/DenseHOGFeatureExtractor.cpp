@@ -0,0 +1,147 @@
+#include "DenseHOGFeatureExtractor.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include "gradientMex.hpp"
+#include "math_helper.hpp"
+
+DenseHOGFeatureExtractor::DenseHOGFeatureExtractor()
+{
+}
+
+DenseHOGFeatureExtractor::~DenseHOGFeatureExtractor()
+{
+}
+
+std::shared_ptr< FC > DenseHOGFeatureExtractor::getFeatures( const cv::Mat & image, const cv::Rect_< double > & boundingBox, int cellSize ) const
+{
+	//The window cut out by getSubWindow, see HOGFeatureExtractor
+	const cv::Point_< double > center = centerPoint( boundingBox );
+	const int width = static_cast< int >( boundingBox.width );
+	const int height = static_cast< int >( boundingBox.height );
+	const int xs = static_cast< int >( std::floor( center.x ) - std::floor( width / 2.0 ) ) + 1;
+	const int ys = static_cast< int >( std::floor( center.y ) - std::floor( height / 2.0 ) ) + 1;
+	const cv::Rect window( xs, ys, width, height );
+	const bool aligned = ( xs % cellSize == 0 && ys % cellSize == 0 );
+	const bool inside = ( ( window & cv::Rect( cv::Point(), image.size() ) ) == window );
+
+	if( !aligned && !inside )
+	{
+		return this->m_windowExtractor.getFeatures( image, boundingBox, cellSize );
+	}
+
+	std::shared_ptr< FrameMaps > frameMaps = this->getFrameMaps( image );
+	const CellMaps & maps = this->getCellMaps( *frameMaps, cellSize );
+
+	if( !maps.map )
+	{
+		return this->m_windowExtractor.getFeatures( image, boundingBox, cellSize );
+	}
+
+	//Off grid windows are binned from the gradients of the frame around them
+	if( !aligned )
+	{
+		auto features = std::make_shared< FC >();
+		const cv::Mat & input = ( image.type() == CV_16UC1 ? frameMaps->frame : frameMaps->frameFloat );
+		piotr::cvFhogWindow< Real, FC >( input, maps.magnitudes, maps.orientations, window, features, cellSize );
+		return features;
+	}
+
+	const cv::Rect cells( xs / cellSize, ys / cellSize, width / cellSize, height / cellSize );
+	const cv::Rect overlap = cells & cv::Rect( cv::Point(), maps.map->channels[ 0 ].size() );
+
+	if( overlap.area() == 0 )
+	{
+		std::cerr << "Error : DenseHOGFeatureExtractor::getFeatures : the window is outside the frame!" << std::endl;
+		return nullptr;
+	}
+
+	auto features = std::make_shared< FC >( maps.map->numberOfChannels() );
+	features->allocate( cells.size(), maps.map->channels[ 0 ].type() );
+
+	//The parts of the window outside the frame replicate the border cells
+	for( size_t c = 0; c < maps.map->numberOfChannels(); c++ )
+	{
+		cv::copyMakeBorder( maps.map->channels[ c ]( overlap ), features->channels[ c ],
+			overlap.y - cells.y, cells.br().y - overlap.br().y, overlap.x - cells.x, cells.br().x - overlap.br().x, cv::BORDER_REPLICATE );
+	}
+
+	return features;
+}
+
+void DenseHOGFeatureExtractor::nextFrame()
+{
+	std::lock_guard< std::mutex > lock( this->m_mutex );
+	this->m_frames.clear();
+}
+
+std::shared_ptr< DenseHOGFeatureExtractor::FrameMaps > DenseHOGFeatureExtractor::getFrameMaps( const cv::Mat & image ) const
+{
+	std::lock_guard< std::mutex > lock( this->m_mutex );
+
+	for( const std::shared_ptr< FrameMaps > & maps : this->m_frames )
+	{
+		if( maps->frame.data == image.data && maps->frame.size() == image.size() && maps->frame.type() == image.type() )
+		{
+			return maps;
+		}
+	}
+
+	//A new frame replaces the previous frame of the same modality
+	this->m_frames.erase( std::remove_if( this->m_frames.begin(), this->m_frames.end(),
+		[&image]( const std::shared_ptr< FrameMaps > & maps ) -> bool
+		{
+			return maps->frame.size() == image.size() && maps->frame.type() == image.type();
+		} ), this->m_frames.end() );
+
+	auto maps = std::make_shared< FrameMaps >();
+	maps->frame = image;
+	this->m_frames.push_back( maps );
+
+	return maps;
+}
+
+const DenseHOGFeatureExtractor::CellMaps & DenseHOGFeatureExtractor::getCellMaps( FrameMaps & frameMaps, int cellSize ) const
+{
+	CellMaps * maps;
+
+	{
+		std::lock_guard< std::mutex > lock( frameMaps.mutex );
+		maps = &frameMaps.cells[ cellSize ];
+	}
+
+	//The first caller computes the maps, later callers of the same cell size wait for it; the gradients
+	//are computed sequentially, a parallel loop could run a task asking for the same maps on this thread
+	std::call_once( maps->computed, [&frameMaps, maps, cellSize]() -> void
+		{
+			const cv::Mat & frame = frameMaps.frame;
+
+			if( frame.cols < cellSize || frame.rows < cellSize )
+			{
+				return;
+			}
+
+			//Depth maps are binned straight from the 16 bit values, other frames are converted once for all cell sizes
+			if( frame.type() != CV_16UC1 )
+			{
+				std::call_once( frameMaps.converted, [&frameMaps]() -> void
+					{
+						frameMaps.frame.convertTo( frameMaps.frameFloat, CV_32F );
+					} );
+			}
+
+			const cv::Mat & input = ( frame.type() == CV_16UC1 ? frame : frameMaps.frameFloat );
+			maps->magnitudes.create( input.size(), CV_32FC1 );
+			maps->orientations.create( input.size(), CV_32SC1 );
+			piotr::cvFhogGradients( input, maps->magnitudes, maps->orientations, cellSize, cv::Range( 0, input.rows ) );
+
+			maps->map = std::make_shared< FC >();
+			piotr::cvFhogWindow< Real, FC >( input, maps->magnitudes, maps->orientations, cv::Rect( cv::Point(), input.size() ),
+				maps->map, cellSize );
+		} );
+
+	return *maps;
+}
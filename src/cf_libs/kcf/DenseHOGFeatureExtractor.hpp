@@ -0,0 +1,136 @@
+#ifndef _DENSEHOGFEATUREEXTRACTOR_HPP_
+#define _DENSEHOGFEATUREEXTRACTOR_HPP_
+/*
+// License Agreement (3-clause BSD License)
+// Copyright (c) 2016, Jake Hall, Massimo Camplan, Sion Hannuna.
+// Third party copyrights and patents are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the names of the copyright holders nor the names of the contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall copyright holders or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+*/
+
+/*
+DenseHOGFeatureExtractor computes the FHOG features of a whole frame once and
+crops the features of every window from it, instead of running FHOG on each
+window separately. Shared between trackers (see DskcfParameters::denseFeatures),
+the overlapping windows of detection, update and scoring of all trackers cost
+one pass over the frame per modality.
+
+Every cell size costs one pass over the frame, which computes the gradients of
+the whole frame and bins them into a map whose cell grid starts at the frame's
+top left corner. A window aligned with that grid is cut from the map; its inner
+cells match the features of HOGFeatureExtractor up to rounding, the cells at its
+border see the pixels outside the window rather than a replicated border, and
+the parts outside the frame replicate the border cells instead of the border
+pixels. Any other window inside the frame is binned from the shared gradients,
+which gives exactly the features of HOGFeatureExtractor at the cost of the
+binning alone. Windows that are neither aligned nor inside the frame are
+extracted by HOGFeatureExtractor.
+
+The pass runs the first time a cell size of a frame is requested, outside the
+lock of the extractor, so trackers only wait for the maps they need.
+
+The maps are kept for the latest frame of every size and type, recognised by
+its buffer. A frame whose buffer is overwritten in place for the next frame is
+not noticed; callers that do so must call nextFrame() in between.
+*/
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#include "FeatureExtractor.hpp"
+#include "HOGFeatureExtractor.hpp"
+#include "feature_channels.hpp"
+
+class DenseHOGFeatureExtractor : public FeatureExtractor
+{
+public:
+	DenseHOGFeatureExtractor();
+	virtual ~DenseHOGFeatureExtractor();
+
+	virtual std::shared_ptr< FC > getFeatures(
+		const cv::Mat & image,
+		const cv::Rect_< double > & boundingBox,
+		int cellSize
+	) const;
+
+	/**
+	 * Drops the maps of all frames, the next request for any frame computes them again.
+	 */
+	void nextFrame();
+private:
+	/** The gradients and the map of one frame for one cell size */
+	struct CellMaps
+	{
+		/** Computes the members below once, see getCellMaps */
+		std::once_flag computed;
+
+		/** The gradient magnitudes and orientations of the frame, see piotr::cvFhogGradients */
+		cv::Mat magnitudes;
+		cv::Mat orientations;
+
+		/** The features of the whole frame, null if the frame is smaller than a cell */
+		std::shared_ptr< FC > map;
+	};
+
+	/** The maps of one frame */
+	struct FrameMaps
+	{
+		/** Holds the frame, so that its buffer cannot be reused by a later frame while the maps are cached */
+		cv::Mat frame;
+
+		/** The frame converted to float, the input of every map except for depth maps */
+		cv::Mat frameFloat;
+		std::once_flag converted;
+
+		/** Per cell size, created on request */
+		std::map< int, CellMaps > cells;
+
+		/** Guards cells, held only to look them up */
+		std::mutex mutex;
+	};
+
+	/**
+	 * @returns The maps of image, replacing those of the previous frame of the same size and type.
+	 */
+	std::shared_ptr< FrameMaps > getFrameMaps( const cv::Mat & image ) const;
+
+	/**
+	 * @returns The gradients and map of the frame for cellSize, computed by the first caller.
+	 */
+	const CellMaps & getCellMaps( FrameMaps & maps, int cellSize ) const;
+
+	/** Extracts the windows that cannot use the maps */
+	HOGFeatureExtractor m_windowExtractor;
+
+	mutable std::mutex m_mutex;
+	mutable std::vector< std::shared_ptr< FrameMaps > > m_frames;
+};
+
+#endif
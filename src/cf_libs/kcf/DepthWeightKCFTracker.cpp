@@ -2,9 +2,11 @@
 #include "DepthWeightKCFTracker.h"
 #include "math_helper.hpp"
 
+#include <limits>
+
 DepthWeightKCFTracker::DepthWeightKCFTracker( KcfParameters paras, std::shared_ptr< Kernel > kernel ) : KcfTracker( paras, kernel )
 {
-  this->m_cellSize = paras.cellSize;
+  this->m_responseAnalyser.setMaxPeaks( DEPTH_WEIGHTED_PEAKS );
 }
 
 DepthWeightKCFTracker::~DepthWeightKCFTracker()
@@ -18,50 +20,52 @@ const DetectResult DepthWeightKCFTracker::detect( const cv::Mat & image, const s
   //Otherwise give the default kcf max response.
   if( image.type() == CV_16UC1 )
   {
-    DetectResult result;
     Response newResponse = this->getResponse( image, features, cv::Point_< double >( position.x, position.y ) );
-    std::vector< cv::MatIterator_< double > > pixels;
 
-    for( cv::MatIterator_< double > itr = newResponse.response.begin(); itr != newResponse.response.end(); itr++ )
-    {
-      pixels.push_back( itr );
-    }
+    return this->weightByDepth( image, newResponse, position, depth, std, this->m_cellSize );
+  }
+  else
+  {
+    return KcfTracker::detect( image, features, position );
+  }
+}
+
+const std::vector< DetectResult > DepthWeightKCFTracker::detectScales( const cv::Mat & image, const std::vector< std::shared_ptr< FC > > & features,
+  const cv::Point_< double > & position, const std::vector< double > & cellScales, const double depth, const double std ) const
+{
+  if( image.type() == CV_16UC1 )
+  {
+    CV_Assert( features.size() == cellScales.size() );
 
-    std::sort( pixels.begin(), pixels.end(),
-               []( cv::MatIterator_< double > a, cv::MatIterator_< double > b ) -> bool
-                {
-                  return (*a) > (*b);
-                }
-    );
+    std::vector< Response > responses = this->getResponses( features );
+    std::vector< DetectResult > result( responses.size() );
 
-	double absoluteMax=*pixels[ 0 ];
-    
-    for( int i = 0; i < std::min< int >( 20, pixels.size() ); i++ )
+    for( size_t i = 0; i < responses.size(); i++ )
     {
-      cv::Point_< double > subDelta = subPixelDelta< double >( newResponse.response, pixels[ i ].pos() );
-
-      if( subDelta.x > newResponse.response.cols / 2 )
-      {
-        subDelta.x -= newResponse.response.cols;
-      }
+      result[ i ] = this->weightByDepth( image, responses[ i ], position, depth, std, this->m_cellSize * cellScales[ i ] );
+    }
 
-      if( subDelta.y > newResponse.response.rows / 2 )
-      {
-        subDelta.y -= newResponse.response.rows;
-      }
+    return result;
+  }
+  else
+  {
+    return KcfTracker::detectScales( image, features, position, cellScales );
+  }
+}
 
-      cv::Point posImagePlane = position + ( this->m_cellSize * subDelta );
-      posImagePlane.x = std::max( 0, std::min( image.cols - 1, posImagePlane.x ) );
-      posImagePlane.y = std::max( 0, std::min( image.rows - 1, posImagePlane.y ) );
-      double _depth = image.at< ushort >( posImagePlane );
+const DetectResult DepthWeightKCFTracker::weightByDepth( const cv::Mat & image, Response & newResponse, const cv::Point_< double > & position,
+  const double depth, const double std, const double cellSize ) const
+{
+  DetectResult result;
+  const std::vector< ResponsePeak > & peaks = newResponse.analysis.peaks;
 
-      *pixels[ i ] *= weightDistanceLogisticOnDepth( depth, _depth, std );
-    }
+	double absoluteMax=peaks[ 0 ].value;
+  size_t bestPeak = 0;
+  Real bestValue = -std::numeric_limits< Real >::max();
 
-    auto itr = std::max_element( pixels.begin(), pixels.begin()+20, []( cv::MatIterator_< double > a, cv::MatIterator_< double > b ) -> bool { return (*a) < (*b); } );
-    newResponse.maxResponse = **itr;
-    newResponse.maxResponsePosition = itr->pos();
-    cv::Point_< double > subDelta = subPixelDelta< double >( newResponse.response, newResponse.maxResponsePosition );
+  for( size_t i = 0; i < peaks.size(); i++ )
+  {
+    cv::Point_< double > subDelta = peaks[ i ].subPixelPosition;
 
     if( subDelta.x > newResponse.response.cols / 2 )
     {
@@ -71,16 +75,43 @@ const DetectResult DepthWeightKCFTracker::detect( const cv::Mat & image, const s
     if( subDelta.y > newResponse.response.rows / 2 )
     {
       subDelta.y -= newResponse.response.rows;
-    };
+    }
 
+    cv::Point posImagePlane = position + ( cellSize * subDelta );
+    posImagePlane.x = std::max( 0, std::min( image.cols - 1, posImagePlane.x ) );
+    posImagePlane.y = std::max( 0, std::min( image.rows - 1, posImagePlane.y ) );
+    double _depth = image.at< ushort >( posImagePlane );
 
-	result.maxResponse = absoluteMax;
-	result.position = position + ( this->m_cellSize * subDelta );
+    Real & value = newResponse.response( peaks[ i ].position );
+    value *= weightDistanceLogisticOnDepth( depth, _depth, std );
 
-    return result;
+    if( value > bestValue )
+    {
+      bestValue = value;
+      bestPeak = i;
+    }
   }
-  else
+
+  newResponse.maxResponse = bestValue;
+  newResponse.maxResponsePosition = peaks[ bestPeak ].position;
+  // Refined on the weighted response, whose neighbours of the peak have changed
+  cv::Point_< double > subDelta = subPixelDelta< Real >( newResponse.response, peaks[ bestPeak ].position );
+
+  if( subDelta.x > newResponse.response.cols / 2 )
   {
-    return KcfTracker::detect( image, features, position );
+    subDelta.x -= newResponse.response.cols;
   }
+
+  if( subDelta.y > newResponse.response.rows / 2 )
+  {
+    subDelta.y -= newResponse.response.rows;
+  };
+
+
+	result.maxResponse = absoluteMax;
+  result.psr = newResponse.analysis.psr;
+	result.position = position + ( cellSize * subDelta );
+  result.zf = newResponse.zf;
+
+  return result;
 }
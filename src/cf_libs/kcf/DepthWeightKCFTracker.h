@@ -49,8 +49,23 @@ public:
   virtual ~DepthWeightKCFTracker();
 
   const DetectResult detect( const cv::Mat & image, const std::shared_ptr< FC > & features, const cv::Point_< double > & position, const double depth, const double std ) const;
+
+  /**
+   * The depth weighted counterpart of KcfTracker::detectScales.
+   */
+  const std::vector< DetectResult > detectScales( const cv::Mat & image, const std::vector< std::shared_ptr< FC > > & features,
+    const cv::Point_< double > & position, const std::vector< double > & cellScales, const double depth, const double std ) const;
 private:
-  int m_cellSize;
+  /**
+   * Weights the highest peaks of the last analysed response by the depth at their position.
+   *
+   * @param cellSize The size of a cell of the response in pixels.
+   */
+  const DetectResult weightByDepth( const cv::Mat & image, Response & response, const cv::Point_< double > & position,
+    const double depth, const double std, const double cellSize ) const;
+
+  /** The number of highest response values which are weighted by their depth */
+  static const size_t DEPTH_WEIGHTED_PEAKS = 20;
 };
 
 
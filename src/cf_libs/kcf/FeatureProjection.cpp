@@ -0,0 +1,162 @@
+#include "FeatureProjection.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+/**
+ * @returns The channels as the rows of one matrix, a view on the tensor without the alignment padding of the planes.
+ */
+static cv::Mat channelMatrix( const std::shared_ptr< FC > & features )
+{
+  CV_Assert( features->isContiguous() );
+
+  return features->tensor().reshape( 1, static_cast< int >( features->numberOfChannels() ) )
+    .colRange( 0, features->channels[ 0 ].size().area() );
+}
+
+/**
+ * @returns The features themselves if they are stored in one tensor, or a contiguous copy.
+ */
+static std::shared_ptr< FC > contiguousFeatures( const std::shared_ptr< FC > & features )
+{
+  return features->isContiguous() ? features : features->clone();
+}
+
+FeatureProjection::FeatureProjection( int channels ) :
+  m_channels( channels )
+{
+}
+
+bool FeatureProjection::isEnabled() const
+{
+  return this->m_channels > 0;
+}
+
+void FeatureProjection::init( const std::shared_ptr< FC > & features )
+{
+  if( !this->isEnabled() )
+  {
+    return;
+  }
+
+  this->m_template = features->clone();
+  this->computeBasis();
+}
+
+void FeatureProjection::update( const std::shared_ptr< FC > & features, double interpFactor )
+{
+  if( !this->isEnabled() )
+  {
+    return;
+  }
+
+  FC::lerpFeatures( this->m_template, contiguousFeatures( features ), interpFactor );
+
+  // One step of subspace iteration: the directions C * b of the autocorrelation C = X * X^T,
+  // computed as X * ( B * X )^T without forming C, orthonormalised in order by Gram-Schmidt
+  const cv::Mat x = channelMatrix( this->m_template );
+  cv::Mat projected, directions;
+
+  cv::gemm( this->m_basis, x, 1.0, cv::noArray(), 0.0, projected );
+  cv::gemm( x, projected, 1.0, cv::noArray(), 0.0, directions, cv::GEMM_2_T );
+  directions.convertTo( directions, CV_64F );
+
+  for( int j = 0; j < directions.cols; j++ )
+  {
+    cv::Mat column = directions.col( j );
+
+    for( int i = 0; i < j; i++ )
+    {
+      column -= directions.col( i ).dot( column ) * directions.col( i );
+    }
+
+    const double norm = cv::norm( column );
+
+    // The template does not span the subspace any more, start over from its eigenvectors
+    if( norm < 1e-12 )
+    {
+      this->computeBasis();
+      return;
+    }
+
+    column /= norm;
+  }
+
+  cv::Mat( directions.t() ).convertTo( this->m_basis, cv::DataType< Real >::type );
+}
+
+std::shared_ptr< FC > FeatureProjection::project( const std::shared_ptr< FC > & features ) const
+{
+  if( !this->isEnabled() )
+  {
+    return features;
+  }
+
+  const std::shared_ptr< FC > source = contiguousFeatures( features );
+  auto result = std::make_shared< FC >( this->m_basis.rows );
+  result->allocate( source->channels[ 0 ].size(), source->channels[ 0 ].type() );
+
+  // Every projected channel is a weighted sum of the feature channels, one matrix product over the tensors
+  cv::Mat destination = channelMatrix( result );
+  cv::gemm( this->m_basis, channelMatrix( source ), 1.0, cv::noArray(), 0.0, destination );
+
+  return result;
+}
+
+std::shared_ptr< FC > FeatureProjection::projectTemplate() const
+{
+  return this->project( this->m_template );
+}
+
+std::shared_ptr< FC > FeatureProjection::backProject( const std::shared_ptr< FC > & projected ) const
+{
+  if( !this->isEnabled() )
+  {
+    return projected;
+  }
+
+  const std::shared_ptr< FC > source = contiguousFeatures( projected );
+  auto result = std::make_shared< FC >( this->m_basis.cols );
+  result->allocate( source->channels[ 0 ].size(), source->channels[ 0 ].type() );
+
+  cv::Mat destination = channelMatrix( result );
+  cv::gemm( this->m_basis, channelMatrix( source ), 1.0, cv::noArray(), 0.0, destination, cv::GEMM_1_T );
+
+  return result;
+}
+
+FeatureProjection FeatureProjection::resized( const cv::Size & size ) const
+{
+  FeatureProjection result = this->clone();
+
+  if( result.m_template )
+  {
+    const cv::Rect whole( cv::Point(), result.m_template->channels[ 0 ].size() );
+    result.m_template = FC::resizeFeatures( result.m_template, whole, size );
+  }
+
+  return result;
+}
+
+FeatureProjection FeatureProjection::clone() const
+{
+  FeatureProjection result( this->m_channels );
+
+  result.m_template = this->m_template ? this->m_template->clone() : nullptr;
+  result.m_basis = this->m_basis.clone();
+
+  return result;
+}
+
+void FeatureProjection::computeBasis()
+{
+  const cv::Mat x = channelMatrix( this->m_template );
+  const int channels = std::min( this->m_channels, x.rows );
+  cv::Mat autocorrelation, eigenvalues, eigenvectors;
+
+  cv::mulTransposed( x, autocorrelation, false, cv::noArray(), 1.0, CV_64F );
+  cv::eigen( autocorrelation, eigenvalues, eigenvectors );
+
+  // The eigenvectors are the rows, ordered by decreasing eigenvalue
+  eigenvectors.rowRange( 0, channels ).convertTo( this->m_basis, cv::DataType< Real >::type );
+}
@@ -0,0 +1,110 @@
+#ifndef _FEATUREPROJECTION_HPP_
+#define _FEATUREPROJECTION_HPP_
+/*
+// License Agreement (3-clause BSD License)
+// Copyright (c) 2016, Jake Hall, Massimo Camplan, Sion Hannuna.
+// Third party copyrights and patents are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the names of the copyright holders nor the names of the contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall copyright holders or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+*/
+
+#include <memory>
+
+#include <opencv2/core/core.hpp>
+
+#include "Typedefs.hpp"
+#include "feature_channels.hpp"
+
+/**
+ * FeatureProjection compresses the feature channels of a model to a few channels with an
+ * online PCA, so that every transform and spectral operation of the model runs on fewer channels.
+ *
+ * The basis spans the principal directions of an appearance template, the features blended
+ * with the learning rate of the model. It is computed once by an eigen decomposition at
+ * init; every update then moves it by one step of subspace iteration towards the updated
+ * template, so it follows the appearance as slowly as the model does. Model and candidates
+ * are always projected onto the same orthonormal basis, so the kernel correlations between
+ * them do not depend on the orientation of the basis within the subspace.
+ */
+class FeatureProjection
+{
+public:
+  /**
+   * @param channels The number of channels the features are projected to, 0 disables the projection.
+   */
+  FeatureProjection( int channels = 0 );
+
+  /** @returns True if the features are projected, false if they are passed through unchanged */
+  bool isEnabled() const;
+
+  /**
+   * Learns the basis of the training features of the first frame.
+   */
+  void init( const std::shared_ptr< FC > & features );
+
+  /**
+   * Blends the features into the appearance template and moves the basis towards it.
+   *
+   * @param interpFactor The learning rate of the model.
+   */
+  void update( const std::shared_ptr< FC > & features, double interpFactor );
+
+  /**
+   * @returns The features projected onto the basis, in a new tensor, or features itself if the projection is disabled.
+   */
+  std::shared_ptr< FC > project( const std::shared_ptr< FC > & features ) const;
+
+  /**
+   * @returns The appearance template projected onto the basis.
+   */
+  std::shared_ptr< FC > projectTemplate() const;
+
+  /**
+   * Maps projected channels, e.g. a spatial filter, back to the feature channels. The transpose of project.
+   */
+  std::shared_ptr< FC > backProject( const std::shared_ptr< FC > & projected ) const;
+
+  /**
+   * @returns A copy with the appearance template resampled to a new grid size, see KcfTracker::onScaleChange.
+   */
+  FeatureProjection resized( const cv::Size & size ) const;
+
+  /** @returns A deep copy, see CopyOnWrite */
+  FeatureProjection clone() const;
+private:
+  /** Sets the basis to the leading eigenvectors of the autocorrelation of the template channels */
+  void computeBasis();
+
+  int m_channels;
+
+  /** The windowed features blended over all frames, with every feature channel */
+  std::shared_ptr< FC > m_template;
+
+  /** One row per projected channel, orthonormal */
+  Mat1r m_basis;
+};
+
+#endif
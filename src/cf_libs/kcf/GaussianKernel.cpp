@@ -1,35 +1,69 @@
 #include "GaussianKernel.hpp"
 
-GaussianKernel::GaussianKernel()
+GaussianKernel::GaussianKernel( bool fourierSum )
 {
 	this->sigma = 0.5;
+	this->fourierSum = fourierSum;
 }
 
 cv::Mat GaussianKernel::correlation(const std::shared_ptr< FC > & xf, const std::shared_ptr< FC > & yf) const
 {
-	double xx, yy, numel;
-	cv::Mat xy, kf;
-	std::shared_ptr< FC > xyf, realXy;
+	double xx, yy;
 
 	if (xf == yf)
 	{
-		yy = xx = FC::squaredNormFeaturesNoCcs(xf);
+		yy = xx = FC::squaredNormFeaturesCcs(xf);
 	}
 	else
 	{
-		xx = FC::squaredNormFeaturesNoCcs(xf);
-		yy = FC::squaredNormFeaturesNoCcs(yf);
+		xx = FC::squaredNormFeaturesCcs(xf);
+		yy = FC::squaredNormFeaturesCcs(yf);
+	}
+
+	return this->correlationFromNorms(xf, yf, xx, yy);
+}
+
+KernelCache GaussianKernel::createCache(const std::shared_ptr< FC > & yf) const
+{
+	KernelCache cache;
+	cache.squaredNorm = FC::squaredNormFeaturesCcs(yf);
+	cache.valid = true;
+
+	return cache;
+}
+
+cv::Mat GaussianKernel::correlation(const std::shared_ptr< FC > & xf, const std::shared_ptr< FC > & yf, const KernelCache & yfCache) const
+{
+	if (!yfCache.valid)
+	{
+		return this->correlation(xf, yf);
 	}
 
-	xyf = FC::mulSpectrumsFeatures(xf, yf, true);
-	realXy = FC::idftFeatures(xyf);
+	double xx = (xf == yf) ? yfCache.squaredNorm : FC::squaredNormFeaturesCcs(xf);
 
-	xy = FC::sumFeatures(realXy);
+	return this->correlationFromNorms(xf, yf, xx, yfCache.squaredNorm);
+}
+
+cv::Mat GaussianKernel::correlationFromNorms(const std::shared_ptr< FC > & xf, const std::shared_ptr< FC > & yf, double xx, double yy) const
+{
+	double numel;
+	cv::Mat xy, kf;
+	std::shared_ptr< FC > realXy;
+
+	if (this->fourierSum)
+	{
+		FFTEngine::getDefault()->idft(FC::mulSpectrumsSumFeatures(xf, yf, true), xy, cv::DFT_REAL_OUTPUT | cv::DFT_SCALE);
+	}
+	else
+	{
+		realXy = FC::idftFeatures(FC::mulSpectrumsFeatures(xf, yf, true));
+		xy = FC::sumFeatures(realXy);
+	}
 
 	numel = static_cast<double>(xf->channels[0].total() * xf->numberOfChannels());
 	this->calculateGaussianTerm(xy, numel, xx, yy);
 
-	dft(xy, kf, cv::DFT_COMPLEX_OUTPUT);
+	FFTEngine::getDefault()->dft(xy, kf, 0);
 
 	return kf;
 }
@@ -42,16 +76,17 @@ void GaussianKernel::calculateGaussianTerm(cv::Mat & xy, double numel, double xx
 	width *= height;
 	height = 1;
 
-	const double summands = xx + yy;
-	const double fraction = -1 / (this->sigma * this->sigma);
+	const Real summands = static_cast< Real >(xx + yy);
+	const Real fraction = static_cast< Real >(-1 / (this->sigma * this->sigma));
+	const Real numelReal = static_cast< Real >(numel);
 
 	for (int row = 0; row < height; ++row)
 	{
-		double* xyd = xy.ptr< double >(row);
+		Real* xyd = xy.ptr< Real >(row);
 
 		for (int col = 0; col < width; ++col)
 		{
-			xyd[col] = (summands - 2 * xyd[col]) / numel;
+			xyd[col] = (summands - 2 * xyd[col]) / numelReal;
 
 			if (xyd[col] < 0)
 			{
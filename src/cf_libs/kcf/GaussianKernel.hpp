@@ -79,12 +79,21 @@ in Proc. CVPR, 2010.
 class GaussianKernel : public Kernel
 {
 public:
-	GaussianKernel();
+	/**
+	 * @param fourierSum If true, the cross-spectra of the channels are summed in the Fourier
+	 *   domain and inverted with a single inverse DFT. Otherwise every channel is inverted
+	 *   separately and summed in the spatial domain, as in the original implementation.
+	 */
+	GaussianKernel( bool fourierSum = true );
 
 	virtual cv::Mat correlation(const std::shared_ptr< FC > & xf, const std::shared_ptr< FC > & yf) const;
+	virtual KernelCache createCache(const std::shared_ptr< FC > & yf) const;
+	virtual cv::Mat correlation(const std::shared_ptr< FC > & xf, const std::shared_ptr< FC > & yf, const KernelCache & yfCache) const;
 private:
 	double sigma;
+	bool fourierSum;
 
+	cv::Mat correlationFromNorms(const std::shared_ptr< FC > & xf, const std::shared_ptr< FC > & yf, double xx, double yy) const;
 	void calculateGaussianTerm(cv::Mat & xy, double numel, double xx, double yy) const;
 };
 
@@ -1,11 +1,26 @@
 #include <memory>
 
 #include "HOGFeatureExtractor.hpp"
+#include "ExecutionPolicy.hpp"
 #include "gradientMex.hpp"
 
+/**
+ * @returns The pixels getSubWindow cuts for boundingBox, which may leave the image.
+ */
+static cv::Rect subWindowRect( const cv::Rect_< double > & boundingBox )
+{
+	const cv::Point_< double > center = centerPoint( boundingBox );
+	const int width = static_cast< int >( boundingBox.width );
+	const int height = static_cast< int >( boundingBox.height );
+
+	return cv::Rect(
+		static_cast< int >( std::floor( center.x ) - std::floor( width / 2.0 ) ) + 1,
+		static_cast< int >( std::floor( center.y ) - std::floor( height / 2.0 ) ) + 1,
+		width, height );
+}
+
 HOGFeatureExtractor::HOGFeatureExtractor()
 {
-	this->m_cellSize = 4;
 }
 
 HOGFeatureExtractor::~HOGFeatureExtractor()
@@ -13,17 +28,28 @@ HOGFeatureExtractor::~HOGFeatureExtractor()
 }
 
 std::shared_ptr< FC > HOGFeatureExtractor::getFeatures( const cv::Mat & image,
-																												const cv::Rect_< double > & boundingBox ) const
+																												const cv::Rect_< double > & boundingBox, int cellSize ) const
 {
 	cv::Mat patch;
 
 	if( getSubWindow< double >( image, patch, boundingBox.size(), centerPoint( boundingBox ) ) )
 	{
-	  cv::Mat patchResizedFloat;
-	  patch.convertTo(patchResizedFloat, CV_32FC(3));
-
+	  piotr::FhogWorkspace & workspace = piotr::threadWorkspace();
 	  auto features = std::make_shared< FC >();
-	  piotr::cvFhog< double, FC >(patchResizedFloat, features, this->m_cellSize);
+
+	  if( patch.type() == CV_16UC1 )
+	  {
+	    // Depth maps are binned straight from the 16 bit values, zero (missing) depth does not create edges
+	    piotr::cvFhog< Real, FC >( patch, features, cellSize, 31, workspace );
+	  }
+	  else
+	  {
+	    // The float patch only lives during the extraction, so it is converted into the scratch memory of this thread
+	    cv::Mat patchResizedFloat( patch.size(), CV_32FC( patch.channels() ),
+	      workspace.input.reserve( patch.total() * patch.channels() * sizeof( float ) ) );
+	    patch.convertTo( patchResizedFloat, CV_32F );
+	    piotr::cvFhog< Real, FC >( patchResizedFloat, features, cellSize, 31, workspace );
+	  }
 
 		return features;
 	}
@@ -34,3 +60,79 @@ std::shared_ptr< FC > HOGFeatureExtractor::getFeatures( const cv::Mat & image,
 
 	return nullptr;
 }
+
+std::vector< std::shared_ptr< FC > > HOGFeatureExtractor::getFeaturesBatch( const cv::Mat & image,
+	const std::vector< cv::Rect_< double > > & boundingBoxes, int cellSize ) const
+{
+	const cv::Rect imageRect( 0, 0, image.cols, image.rows );
+	std::vector< cv::Rect > windows( boundingBoxes.size() );
+	cv::Rect region;
+	double windowsArea = 0.0;
+	size_t extractable = 0;
+
+	// As in getSubWindow, a window is extracted as long as it overlaps the image
+	for( size_t index = 0; index < boundingBoxes.size(); ++index )
+	{
+		windows[ index ] = subWindowRect( boundingBoxes[ index ] );
+
+		if( ( windows[ index ] & imageRect ).area() > 0 )
+		{
+			region = ( extractable == 0 ? windows[ index ] : ( region | windows[ index ] ) );
+			windowsArea += windows[ index ].area();
+			++extractable;
+		}
+	}
+
+	// Sharing the gradients only pays off if the windows overlap, far apart windows
+	// would spend more on the pixels between them than they save
+	if( extractable < 2 || static_cast< double >( region.area() ) > windowsArea )
+	{
+		return FeatureExtractor::getFeaturesBatch( image, boundingBoxes, cellSize );
+	}
+
+	// The union of the windows, replicating the border of the image as getSubWindow does
+	const cv::Rect inside = region & imageRect;
+	cv::Mat patch = image( inside );
+
+	if( inside != region )
+	{
+		cv::copyMakeBorder( patch, patch, inside.y - region.y, region.br().y - inside.br().y,
+			inside.x - region.x, region.br().x - inside.br().x, cv::BORDER_REPLICATE );
+	}
+
+	if( patch.type() != CV_16UC1 )
+	{
+		patch.convertTo( patch, CV_32F );
+	}
+
+	cv::Mat1f magnitudes( patch.size() );
+	cv::Mat1i orientations( patch.size() );
+	const int rowGrain = std::max( 1, ExecutionPolicy::current().tensorGrain / patch.cols );
+
+	parallelForBlocks( 0, patch.rows, rowGrain,
+		[&patch, &magnitudes, &orientations, cellSize]( const tbb::blocked_range< int > & rows ) -> void
+		{
+			piotr::cvFhogGradients( patch, magnitudes, orientations, cellSize, cv::Range( rows.begin(), rows.end() ) );
+		}
+	);
+
+	std::vector< std::shared_ptr< FC > > result( boundingBoxes.size() );
+
+	parallelFor< size_t >( 0, windows.size(),
+		[&imageRect, &windows, &region, &patch, &magnitudes, &orientations, cellSize, &result]( size_t index ) -> void
+		{
+			if( ( windows[ index ] & imageRect ).area() > 0 )
+			{
+				result[ index ] = std::make_shared< FC >();
+				piotr::cvFhogWindow< Real, FC >( patch, magnitudes, orientations, windows[ index ] - region.tl(),
+					result[ index ], cellSize );
+			}
+			else
+			{
+				std::cerr << "Error : HOGFeatureExtractor::getFeaturesBatch : getSubWindow failed!" << std::endl;
+			}
+		}
+	);
+
+	return result;
+}
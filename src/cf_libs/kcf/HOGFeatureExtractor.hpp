@@ -84,10 +84,19 @@ public:
 
 	virtual std::shared_ptr< FC > getFeatures(
 		const cv::Mat & image,
-		const cv::Rect_< double > & boundingBox
+		const cv::Rect_< double > & boundingBox,
+		int cellSize
+	) const;
+
+	/**
+	 * Computes the gradients once over the union of the windows and bins every window from them,
+	 * the windows in parallel. The features equal those of getFeatures for each window.
+	 */
+	virtual std::vector< std::shared_ptr< FC > > getFeaturesBatch(
+		const cv::Mat & image,
+		const std::vector< cv::Rect_< double > > & boundingBoxes,
+		int cellSize
 	) const;
-private:
-	int m_cellSize;
 };
 
 #endif
@@ -6,4 +6,14 @@ Kernel::Kernel()
 
 Kernel::~Kernel()
 {
+}
+
+KernelCache Kernel::createCache( const std::shared_ptr< FC > & yf ) const
+{
+	return KernelCache();
+}
+
+cv::Mat Kernel::correlation( const std::shared_ptr< FC > & xf, const std::shared_ptr< FC > & yf, const KernelCache & yfCache ) const
+{
+	return this->correlation( xf, yf );
 }
\ No newline at end of file
@@ -75,6 +75,20 @@ in Proc. CVPR, 2010.
 #include <opencv2/core.hpp>
 #include "feature_channels.hpp"
 
+/**
+ * KernelCache holds the terms of a kernel correlation which depend only on
+ * one of its operands, so they can be computed once for a model and reused
+ * until the model changes.
+ */
+struct KernelCache
+{
+	/** The squared norm of the cached spectra */
+	double squaredNorm = 0.0;
+
+	/** False if the kernel does not use a cache or it has not been computed */
+	bool valid = false;
+};
+
 class Kernel
 {
 public:
@@ -82,6 +96,20 @@ public:
 	virtual ~Kernel();
 
 	virtual cv::Mat correlation( const std::shared_ptr< FC > & xf, const std::shared_ptr< FC > & yf ) const = 0;
+
+	/**
+	 * Computes the terms of the correlation which depend only on yf.
+	 * The default implementation returns an invalid cache.
+	 *
+	 * @param yf The spectra to precompute the terms for, usually the model.
+	 */
+	virtual KernelCache createCache( const std::shared_ptr< FC > & yf ) const;
+
+	/**
+	 * Correlates xf with yf using terms precomputed by createCache( yf ).
+	 * The default implementation ignores the cache.
+	 */
+	virtual cv::Mat correlation( const std::shared_ptr< FC > & xf, const std::shared_ptr< FC > & yf, const KernelCache & yfCache ) const;
 };
 
 #endif
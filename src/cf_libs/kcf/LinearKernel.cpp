@@ -0,0 +1,16 @@
+#include "LinearKernel.hpp"
+
+LinearKernel::LinearKernel()
+{
+}
+
+cv::Mat LinearKernel::correlation(const std::shared_ptr< FC > & xf, const std::shared_ptr< FC > & yf) const
+{
+	// kf = sum( xf .* conj( yf ), 3 ) / numel( xf )
+	cv::Mat kf = FC::mulSpectrumsSumFeatures(xf, yf, true);
+	double numel = static_cast<double>(xf->channels[0].total() * xf->numberOfChannels());
+
+	kf *= 1.0 / numel;
+
+	return kf;
+}
@@ -0,0 +1,23 @@
+#include "PolynomialKernel.hpp"
+
+PolynomialKernel::PolynomialKernel( double additive, double exponent )
+{
+	this->additive = additive;
+	this->exponent = exponent;
+}
+
+cv::Mat PolynomialKernel::correlation(const std::shared_ptr< FC > & xf, const std::shared_ptr< FC > & yf) const
+{
+	cv::Mat xy, kf;
+	double numel = static_cast<double>(xf->channels[0].total() * xf->numberOfChannels());
+
+	FFTEngine::getDefault()->idft(FC::mulSpectrumsSumFeatures(xf, yf, true), xy, cv::DFT_REAL_OUTPUT | cv::DFT_SCALE);
+
+	// kf = fft2( ( xy / numel( xf ) + a ) .^ b )
+	xy.convertTo(xy, -1, 1.0 / numel, this->additive);
+	cv::pow(xy, this->exponent, xy);
+
+	FFTEngine::getDefault()->dft(xy, kf, 0);
+
+	return kf;
+}
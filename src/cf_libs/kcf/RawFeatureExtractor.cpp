@@ -0,0 +1,62 @@
+#include "RawFeatureExtractor.hpp"
+
+#include <iostream>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include "math_helper.hpp"
+
+RawFeatureExtractor::RawFeatureExtractor()
+{
+}
+
+RawFeatureExtractor::~RawFeatureExtractor()
+{
+}
+
+std::shared_ptr< FC > RawFeatureExtractor::getFeatures( const cv::Mat & image, const cv::Rect_< double > & boundingBox, int cellSize ) const
+{
+	cv::Mat patch;
+
+	if( !getSubWindow< double >( image, patch, boundingBox.size(), centerPoint( boundingBox ) ) )
+	{
+		std::cerr << "Error : RawFeatureExtractor::getFeatures : getSubWindow failed!" << std::endl;
+		return nullptr;
+	}
+
+	//The grid of HOGFeatureExtractor, pixels beyond the last full cell are dropped
+	const cv::Size grid( patch.cols / cellSize, patch.rows / cellSize );
+
+	if( grid.area() == 0 )
+	{
+		std::cerr << "Error : RawFeatureExtractor::getFeatures : the window is smaller than a cell!" << std::endl;
+		return nullptr;
+	}
+
+	cv::Mat pixels = patch( cv::Rect( 0, 0, grid.width * cellSize, grid.height * cellSize ) );
+	cv::Mat intensity, intensityFloat;
+
+	if( pixels.channels() == 3 )
+	{
+		cv::cvtColor( pixels, intensity, cv::COLOR_BGR2GRAY );
+	}
+	else
+	{
+		intensity = pixels;
+	}
+
+	//INTER_AREA with an integer factor is the mean of every cell
+	auto features = std::make_shared< FC >( 1 );
+	features->allocate( grid, cv::DataType< Real >::type );
+	cv::Mat & cells = features->channels[ 0 ];
+
+	intensity.convertTo( intensityFloat, cv::DataType< Real >::type );
+	cv::resize( intensityFloat, cells, grid, 0, 0, cv::INTER_AREA );
+
+	double maxValue = 0.0;
+	cv::minMaxLoc( cells, nullptr, &maxValue );
+
+	const double scale = maxValue > 0.0 ? 1.0 / maxValue : 1.0;
+	cells.convertTo( cells, -1, scale, -scale * cv::mean( cells )[ 0 ] );
+
+	return features;
+}
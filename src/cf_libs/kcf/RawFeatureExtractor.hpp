@@ -0,0 +1,62 @@
+#ifndef _RAWFEATUREEXTRACTOR_HPP_
+#define _RAWFEATUREEXTRACTOR_HPP_
+/*
+// License Agreement (3-clause BSD License)
+// Copyright (c) 2016, Jake Hall, Massimo Camplan, Sion Hannuna.
+// Third party copyrights and patents are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the names of the copyright holders nor the names of the contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall copyright holders or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+*/
+
+#include <memory>
+
+#include <opencv2/core/core.hpp>
+
+#include "FeatureExtractor.hpp"
+#include "feature_channels.hpp"
+
+/**
+ * RawFeatureExtractor uses the intensity of colour images, or the value of depth maps,
+ * averaged over every cell as a single feature channel. The cell grid matches
+ * HOGFeatureExtractor, so the models and windows of the tracker are the same for both.
+ *
+ * The values are divided by their maximum within the window and centred on zero,
+ * as the raw features of KCF, such that colour and depth are on the same scale.
+ */
+class RawFeatureExtractor : public FeatureExtractor
+{
+public:
+	RawFeatureExtractor();
+	virtual ~RawFeatureExtractor();
+
+	virtual std::shared_ptr< FC > getFeatures(
+		const cv::Mat & image,
+		const cv::Rect_< double > & boundingBox,
+		int cellSize
+	) const;
+};
+
+#endif
@@ -1,5 +1,7 @@
 #include "kcf_tracker.hpp"
 
+#include <numeric>
+
 KcfParameters::KcfParameters()
 {
   this->padding = 2.5;
@@ -7,16 +9,17 @@ KcfParameters::KcfParameters()
   this->outputSigmaFactor = 0.05;
   this->interpFactor = 0.02;
   this->cellSize = 4;
+  this->projectedChannels = 0;
 }
 
 KcfTracker::KcfTracker(KcfParameters paras, std::shared_ptr< Kernel > kernel ) :
-    m_xf( nullptr ),
     m_kernel( kernel )
 {
   m_isInitialized = false;
   m_lambda = paras.lambda;
   m_interpFactor = paras.interpFactor;
   m_cellSize = paras.cellSize;
+  m_projectedChannels = paras.projectedChannels;
   m_frameID = 1;
 }
 
@@ -26,26 +29,39 @@ KcfTracker::~KcfTracker()
 
 void KcfTracker::init( const cv::Mat & image, const std::shared_ptr< FC > & features, const cv::Point_< double > & position )
 {
-  TrainingData trainingData = getTrainingData( image, features );
-
   this->m_frameID = 0;
   this->m_isInitialized = false;
 
-  divideSpectrumsNoCcs< double >( trainingData.numeratorf, trainingData.denominatorf, this->m_alphaf );
-  this->m_alphaNumeratorf = trainingData.numeratorf;
-  this->m_alphaDenominatorf = trainingData.denominatorf;
-  this->m_xf = trainingData.xf;
+  // A new model, so duplicates of the previous one are left alone
+  Model model;
+  model.projection = FeatureProjection( this->m_projectedChannels );
+  model.projection.init( features );
+
+  TrainingData trainingData = this->getTrainingData( FC::dftFeatures( model.projection.project( features ) ) );
+  divSpectrumsCcs( trainingData.numeratorf, trainingData.denominatorf, model.alphaf );
+  model.alphaNumeratorf = trainingData.numeratorf;
+  model.alphaDenominatorf = trainingData.denominatorf;
+  model.xf = trainingData.xf;
+  model.xfCache = trainingData.xfCache;
+
+  this->m_model = CopyOnWrite< Model >( model );
   this->m_isInitialized = true;
 }
 
 const KcfTracker::TrainingData KcfTracker::getTrainingData( const cv::Mat & image, const std::shared_ptr< FC > & features ) const
+{
+  return this->getTrainingData( FC::dftFeatures( this->m_model->projection.project( features ) ) );
+}
+
+const KcfTracker::TrainingData KcfTracker::getTrainingData( const std::shared_ptr< FC > & xf ) const
 {
   TrainingData result;
-  result.xf = FC::dftFeatures( features, cv::DFT_COMPLEX_OUTPUT );
-  cv::Mat kf = this->m_kernel->correlation( result.xf, result.xf );
-  cv::Mat kfLambda = kf + this->m_lambda;
-  mulSpectrums( this->m_yf, kf, result.numeratorf, 0 );
-  mulSpectrums( kf, kfLambda, result.denominatorf, 0 );
+  result.xf = xf;
+  result.xfCache = this->m_kernel->createCache( result.xf );
+  cv::Mat kf = this->m_kernel->correlation( result.xf, result.xf, result.xfCache );
+  cv::Mat kfLambda = addRealToSpectrum< Real >( static_cast< Real >( this->m_lambda ), kf );
+  mulSpectrumsCcs( this->m_yf, kf, result.numeratorf );
+  mulSpectrumsCcs( kf, kfLambda, result.denominatorf );
 
   return result;
 }
@@ -56,68 +72,158 @@ void KcfTracker::update( const cv::Mat & image, const std::shared_ptr< FC > & fe
 
   if( m_isInitialized )
   {
-    this->updateModel( image, features );
+    // The new features are projected onto the basis which already learnt them
+    this->m_model.write().projection.update( features, this->m_interpFactor );
+    this->updateModel( this->getTrainingData( image, features ) );
+  }
+}
+
+void KcfTracker::updateFromSpectrum( const std::shared_ptr< FC > & xf )
+{
+  ++m_frameID;
+
+  if( m_isInitialized )
+  {
+    Model & model = this->m_model.write();
+
+    // Only the part of the sample inside the current basis reaches the appearance template
+    if( model.projection.isEnabled() )
+    {
+      model.projection.update( model.projection.backProject( FC::idftFeatures( xf ) ), this->m_interpFactor );
+    }
+
+    this->updateModel( this->getTrainingData( xf ) );
   }
 }
 
 const DetectResult KcfTracker::detectModel( const cv::Mat & image, const std::shared_ptr< FC > & features, const Point & newPos ) const
 {
-  DetectResult result;
-  Response newResponse = this->getResponse( image, features, newPos );
+  return this->resultFromResponse( this->getResponse( image, features, newPos ), newPos, this->m_cellSize );
+}
 
-  cv::Point_< double > subDelta = subPixelDelta< double >( newResponse.response, newResponse.maxResponsePosition );
+const DetectResult KcfTracker::resultFromResponse( const Response & response, const Point & position, const double cellSize ) const
+{
+  DetectResult result;
+  cv::Point_< double > subDelta = response.analysis.peaks.front().subPixelPosition;
 
-  if( subDelta.y >= newResponse.response.rows / 2 )
+  if( subDelta.y >= response.response.rows / 2 )
   {
-    subDelta.y -= newResponse.response.rows;
+    subDelta.y -= response.response.rows;
   }
-  if( subDelta.x >= newResponse.response.cols / 2 )
+  if( subDelta.x >= response.response.cols / 2 )
   {
-    subDelta.x -= newResponse.response.cols;
+    subDelta.x -= response.response.cols;
   }
-  double posDeltaX = m_cellSize * subDelta.x;
-  double posDeltaY = m_cellSize * subDelta.y;
-  result.position.x = newPos.x + posDeltaX;
-  result.position.y = newPos.y + posDeltaY;
+  double posDeltaX = cellSize * subDelta.x;
+  double posDeltaY = cellSize * subDelta.y;
+  result.position.x = position.x + posDeltaX;
+  result.position.y = position.y + posDeltaY;
 
-  result.maxResponse = newResponse.maxResponse;
+  result.maxResponse = response.maxResponse;
+  result.psr = response.analysis.psr;
+  result.zf = response.zf;
 
   return result;
 }
 
-void KcfTracker::updateModel( const cv::Mat & image, const std::shared_ptr< FC > & features )
+void KcfTracker::updateModel( const TrainingData & trainingData )
 {
-  TrainingData trainingData = getTrainingData( image, features );
+  Model & model = this->m_model.write();
 
-  this->m_alphaNumeratorf   = ( 1 - m_interpFactor ) * m_alphaNumeratorf   + m_interpFactor * trainingData.numeratorf;
-  this->m_alphaDenominatorf = ( 1 - m_interpFactor ) * m_alphaDenominatorf + m_interpFactor * trainingData.denominatorf;
+  lerpInPlace( model.alphaNumeratorf, trainingData.numeratorf, this->m_interpFactor );
+  lerpInPlace( model.alphaDenominatorf, trainingData.denominatorf, this->m_interpFactor );
 
-  FC::mulValueFeatures( this->m_xf, ( 1 - this->m_interpFactor ) );
-  FC::mulValueFeatures( trainingData.xf, this->m_interpFactor );
-  FC::addFeatures( this->m_xf, trainingData.xf );
-  divideSpectrumsNoCcs< double >( m_alphaNumeratorf, m_alphaDenominatorf, this->m_alphaf );
+  if( model.projection.isEnabled() )
+  {
+    // The basis has moved, so the model spectrum is rebuilt from the template instead of blended
+    model.xf = FC::dftFeatures( model.projection.projectTemplate() );
+  }
+  else
+  {
+    FC::lerpFeatures( model.xf, trainingData.xf, this->m_interpFactor );
+  }
+
+  model.xfCache = this->m_kernel->createCache( model.xf );
+  divSpectrumsCcs( model.alphaNumeratorf, model.alphaDenominatorf, model.alphaf );
 }
 
 const KcfTracker::Response KcfTracker::getResponse( const cv::Mat & image, const std::shared_ptr< FC > & features, const Point & pos ) const
 {
   Response result;
 
-  result.response = this->detectResponse( image, features, pos );
-  minMaxLoc( result.response, 0, &result.maxResponse, 0, &result.maxResponsePosition );
+  result.zf = FC::dftFeatures( this->m_model->projection.project( features ) );
+  result.response = this->detectResponse( result.zf );
+  this->analyseResponse( result );
 
   return result;
 }
 
+const std::vector< KcfTracker::Response > KcfTracker::getResponses( const std::vector< std::shared_ptr< FC > > & features ) const
+{
+  std::vector< Response > result( features.size() );
+
+  if( features.empty() )
+  {
+    return result;
+  }
+
+  // Transform the channels of every candidate as one batch, the spectra stay views on one tensor
+  std::vector< std::shared_ptr< FC > > projected( features.size() );
+  std::vector< cv::Mat > channels;
+
+  for( size_t i = 0; i < features.size(); i++ )
+  {
+    projected[ i ] = this->m_model->projection.project( features[ i ] );
+    channels.insert( channels.end(), projected[ i ]->channels.begin(), projected[ i ]->channels.end() );
+  }
+
+  FC spectra( channels.size() );
+  spectra.allocate( channels[ 0 ].size(), channels[ 0 ].type() );
+  FFTEngine::getDefault()->dft( channels, spectra.channels );
+
+  size_t offset = 0;
+
+  for( size_t i = 0; i < features.size(); i++ )
+  {
+    const size_t count = projected[ i ]->numberOfChannels();
+
+    result[ i ].zf = std::make_shared< FC >( count );
+    std::copy( spectra.channels.begin() + offset, spectra.channels.begin() + offset + count, result[ i ].zf->channels.begin() );
+    offset += count;
+  }
+
+  parallelFor< size_t >( 0, result.size(),
+    [this, &result]( size_t index ) -> void
+    {
+      result[ index ].response = this->detectResponse( result[ index ].zf );
+      this->analyseResponse( result[ index ] );
+    }
+  );
+
+  return result;
+}
+
+void KcfTracker::analyseResponse( Response & response ) const
+{
+  this->m_responseAnalyser.analyse( response.response, response.analysis );
+  response.maxResponse = response.analysis.peaks.front().value;
+  response.maxResponsePosition = response.analysis.peaks.front().position;
+}
+
 const cv::Mat KcfTracker::detectResponse( const cv::Mat & image, const std::shared_ptr< FC > & features, const Point & pos ) const
+{
+  return this->detectResponse( FC::dftFeatures( this->m_model->projection.project( features ) ) );
+}
+
+const cv::Mat KcfTracker::detectResponse( const std::shared_ptr< FC > & zf ) const
 {
   cv::Mat responsef;
-  cv::Mat1d response;
+  Mat1r response;
 
-  std::shared_ptr< FC > zf = FC::dftFeatures( features, cv::DFT_COMPLEX_OUTPUT );
-  cv::Mat kzf = this->m_kernel->correlation( zf, this->m_xf );
+  cv::Mat kzf = this->m_kernel->correlation( zf, this->m_model->xf, this->m_model->xfCache );
 
-  mulSpectrums( this->m_alphaf, kzf, responsef, 0, false );
-  idft( responsef, response, cv::DFT_REAL_OUTPUT | cv::DFT_SCALE );
+  mulSpectrumsCcs( this->m_model->alphaf, kzf, responsef );
+  FFTEngine::getDefault()->idft( responsef, response, cv::DFT_REAL_OUTPUT | cv::DFT_SCALE );
 
   return response;
 }
@@ -127,39 +233,118 @@ const DetectResult KcfTracker::detect( const cv::Mat & image, const std::shared_
   return this->detectModel( image, features, position );
 }
 
-void KcfTracker::onScaleChange( const Size & targetSize, const Size & windowSize, const cv::Mat2d & yf, const cv::Mat1d & cosineWindow )
+const std::vector< DetectResult > KcfTracker::detectScales( const cv::Mat & image, const std::vector< std::shared_ptr< FC > > & features,
+  const Point & position, const std::vector< double > & cellScales ) const
 {
+  CV_Assert( features.size() == cellScales.size() );
+
+  std::vector< Response > responses = this->getResponses( features );
+  std::vector< DetectResult > result( responses.size() );
+
+  for( size_t i = 0; i < responses.size(); i++ )
+  {
+    result[ i ] = this->resultFromResponse( responses[ i ], position, this->m_cellSize * cellScales[ i ] );
+  }
+
+  return result;
+}
+
+void KcfTracker::onScaleChange( const Size & targetSize, const Size & windowSize, int cellSize, const Mat1r & yf, const Mat1r & cosineWindow )
+{
+  this->m_cellSize = cellSize;
   this->m_cosineWindow = cosineWindow;
   this->m_yf = yf;
 
   //If the model is initialised, resize it
   if( this->m_isInitialized )
   {
-    cv::Size2i modelSize(
-        cvFloor( windowSize.width / this->m_cellSize ),
-        cvFloor( windowSize.height / this->m_cellSize )
-    );
+    // The labels are sized like the feature grid of the new scale
+    cv::Size2i modelSize = yf.size();
+
+    // The resized model is built next to the current one, which may be shared with duplicates
+    const Model & source = this->m_model.read();
+    Model model;
 
-    tbb::parallel_for_each( this->m_xf->channels.begin(), this->m_xf->channels.end(),
-      [modelSize]( cv::Mat & channel )
+    model.xf = std::make_shared< FC >( source.xf->numberOfChannels() );
+    model.xf->allocate( modelSize, source.xf->channels[ 0 ].type() );
+
+    parallelFor< size_t >( 0, source.xf->numberOfChannels(),
+      [&source, &model, modelSize]( size_t index )
       {
-        channel = ScaleAnalyser::scaleImageFourierShift( channel, modelSize );
+        ScaleAnalyser::scaleImageFourierShiftCcs( source.xf->channels[ index ], modelSize ).copyTo( model.xf->channels[ index ] );
       }
     );
 
-    this->m_alphaNumeratorf = ScaleAnalyser::scaleImageFourierShift( this->m_alphaNumeratorf, modelSize );
-    this->m_alphaDenominatorf = ScaleAnalyser::scaleImageFourierShift( this->m_alphaDenominatorf, modelSize );
+    model.xfCache = this->m_kernel->createCache( model.xf );
+
+    model.alphaNumeratorf = ScaleAnalyser::scaleImageFourierShiftCcs( source.alphaNumeratorf, modelSize );
+    model.alphaDenominatorf = ScaleAnalyser::scaleImageFourierShiftCcs( source.alphaDenominatorf, modelSize );
+
+    // Keep alphaf in line with the resized model, so a detection before the next update sees matching sizes
+    divSpectrumsCcs( model.alphaNumeratorf, model.alphaDenominatorf, model.alphaf );
+
+    model.projection = source.projection.resized( modelSize );
+
+    this->m_model = CopyOnWrite< Model >( model );
   }
 }
 
+const KcfTracker::SpatialFilter KcfTracker::getSpatialFilter() const
+{
+  CV_Assert( this->m_isInitialized );
+
+  // response = idft( alphaf .* sum_c( zf_c .* conj( xf_c ) ) ), so w_c = idft( xf_c .* conj( alphaf ) ) up to a scale
+  SpatialFilter result;
+  const Model & model = this->m_model.read();
+  const size_t channels = model.xf->numberOfChannels();
+  std::vector< double > peaks( channels, 0.0 );
+
+  result.filter = std::make_shared< FC >( channels );
+  result.filter->allocate( model.xf->channels[ 0 ].size(), model.xf->channels[ 0 ].type() );
+
+  parallelFor< size_t >( 0, channels,
+    [this, &model, &result, &peaks]( size_t index ) -> void
+    {
+      cv::Mat wf, w, x;
+
+      mulSpectrumsCcs( model.xf->channels[ index ], model.alphaf, wf, true );
+      FFTEngine::getDefault()->idft( wf, w, cv::DFT_REAL_OUTPUT | cv::DFT_SCALE );
+      FFTEngine::getDefault()->idft( model.xf->channels[ index ], x, cv::DFT_REAL_OUTPUT | cv::DFT_SCALE );
+
+      peaks[ index ] = w.dot( x );
+      cv::multiply( w, this->m_cosineWindow, result.filter->channels[ index ] );
+    }
+  );
+
+  result.peak = std::accumulate( peaks.begin(), peaks.end(), 0.0 );
+  result.cellSize = this->m_cellSize;
+
+  // The filter of the projected channels weights every feature channel through the basis; the peak is unchanged
+  result.filter = model.projection.backProject( result.filter );
+
+  return result;
+}
+
+KcfTracker::Model KcfTracker::Model::clone() const
+{
+  Model result;
+
+  result.alphaNumeratorf = this->alphaNumeratorf.clone();
+  result.alphaDenominatorf = this->alphaDenominatorf.clone();
+  result.alphaf = this->alphaf.clone();
+  result.xf = this->xf ? this->xf->clone() : nullptr;
+  result.xfCache = this->xfCache;
+  result.projection = this->projection.clone();
+
+  return result;
+}
+
 std::shared_ptr< KcfTracker > KcfTracker::duplicate() const
 {
   std::shared_ptr< KcfTracker > result = std::make_shared< KcfTracker >( KcfParameters(), this->m_kernel );
 
-  result->m_xf = this->m_xf;
-  result->m_alphaNumeratorf = this->m_alphaNumeratorf;
-  result->m_alphaDenominatorf = this->m_alphaDenominatorf;
-  result->m_alphaf = this->m_alphaf;
+  // An O(1) snapshot, the first update of either tracker copies the model
+  result->m_model = this->m_model;
   result->m_cosineWindow = this->m_cosineWindow;
   result->m_yf = this->m_yf;
 
@@ -169,6 +354,7 @@ std::shared_ptr< KcfTracker > KcfTracker::duplicate() const
   result->m_lambda = this->m_lambda;
   result->m_interpFactor = this->m_interpFactor;
   result->m_cellSize = this->m_cellSize;
+  result->m_projectedChannels = this->m_projectedChannels;
 
   result->m_kernel = this->m_kernel;
 
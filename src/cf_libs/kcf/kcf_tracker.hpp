@@ -92,6 +92,9 @@ in Proc. CVPR, 2010.
 #include "Kernel.hpp"
 #include "ScaleChangeObserver.hpp"
 #include "optional.hpp"
+#include "ResponseAnalyser.hpp"
+#include "CopyOnWrite.hpp"
+#include "FeatureProjection.hpp"
 
 struct KcfParameters
 {
@@ -101,10 +104,23 @@ struct KcfParameters
   double interpFactor;
   int cellSize;
 
+  /** The number of channels the features are compressed to by an online PCA, 0 keeps every channel */
+  int projectedChannels;
+
   KcfParameters();
 };
 
-struct DetectResult { cv::Point_< double > position;double maxResponse; };
+struct DetectResult
+{
+  cv::Point_< double > position;
+  double maxResponse;
+
+  /** The peak to sidelobe ratio of the response, see ResponseAnalysis */
+  double psr;
+
+  /** The spectrum of the detection features, extracted at the position passed to detect and projected, see FeatureProjection */
+  std::shared_ptr< FC > zf;
+};
 
 class KcfTracker : public ScaleChangeObserver
 {
@@ -115,33 +131,117 @@ public:
 
   void init( const cv::Mat & image, const std::shared_ptr< FC > & features, const cv::Point_< double > & position );
   void update( const cv::Mat & image, const std::shared_ptr< FC > & features, const cv::Point_< double > & position );
-  virtual void onScaleChange( const cv::Size_< double > & targetSize, const cv::Size_< double > & windowSize, const cv::Mat2d & yf, const cv::Mat1d & cosineWindow );
+
+  /**
+   * Update the model from the spectrum of the training features instead of the features themselves,
+   * e.g. from a detection spectrum moved to the new position with FC::shiftSpectrumFeatures.
+   *
+   * @param xf The CCS packed spectrum of the windowed training features, projected like DetectResult::zf.
+   */
+  void updateFromSpectrum( const std::shared_ptr< FC > & xf );
+  virtual void onScaleChange( const cv::Size_< double > & targetSize, const cv::Size_< double > & windowSize, int cellSize,
+    const Mat1r & yf, const Mat1r & cosineWindow );
 
   const DetectResult detect( const cv::Mat & image, const std::shared_ptr< FC > & features, const cv::Point_< double > & position ) const;
+
+  /**
+   * Detects the target at several candidate scales at once. The spectra of all candidates
+   * are computed in one batched transform and their kernel correlations run in parallel.
+   *
+   * @param image The image the features were extracted from.
+   * @param features The windowed features of every candidate, resampled to the model grid.
+   * @param position The position the features were extracted at.
+   * @param cellScales The size of a cell of every candidate, relative to the cell size of the model.
+   *
+   * @returns One result per candidate, in the order of features.
+   */
+  const std::vector< DetectResult > detectScales( const cv::Mat & image, const std::vector< std::shared_ptr< FC > > & features,
+    const cv::Point_< double > & position, const std::vector< double > & cellScales ) const;
+
   std::shared_ptr< KcfTracker > duplicate() const;
+
+  /**
+   * The model as a spatial filter w: sum_c ( w_c * z_c ) evaluated for the features z of a
+   * window equals the response of a linear kernel model, and approximates the response of
+   * the other kernels. The cosine window is folded into w, so it applies to unwindowed features.
+   */
+  struct SpatialFilter
+  {
+    /** One filter per feature channel, sized like the model grid */
+    std::shared_ptr< FC > filter;
+
+    /** The response of the filter on the training features, used to normalise other responses */
+    double peak;
+
+    /** The size of a cell of the filter in pixels */
+    int cellSize;
+  };
+
+  /**
+   * @returns The spatial filter of the model, for the feature channels before the projection.
+   * @warning The tracker must be initialised.
+   */
+  const SpatialFilter getSpatialFilter() const;
 private:
   bool m_isInitialized;
   int m_frameID;
-  int m_cellSize;
   double m_lambda;
   double m_interpFactor;
-  cv::Mat1d m_cosineWindow;
-  cv::Mat2d m_alphaNumeratorf;
-  cv::Mat2d m_alphaDenominatorf;
-  cv::Mat2d m_alphaf;
-  cv::Mat2d m_yf;
-  std::shared_ptr< FC > m_xf;
+  int m_projectedChannels;
+  Mat1r m_cosineWindow;
+  Mat1r m_yf;
+
+  /** The learnt part of the tracker, shared with duplicates until either side updates it */
+  struct Model
+  {
+    Mat1r alphaNumeratorf;
+    Mat1r alphaDenominatorf;
+    Mat1r alphaf;
+    std::shared_ptr< FC > xf;
+    KernelCache xfCache;
+
+    /** The channel compression of xf and of the features compared with it */
+    FeatureProjection projection;
+
+    /** @returns A deep copy of the model, see CopyOnWrite */
+    Model clone() const;
+  };
+
+  CopyOnWrite< Model > m_model;
   std::shared_ptr< Kernel > m_kernel;
-
-  void updateModel( const cv::Mat & image, const std::shared_ptr< FC > & features );
 protected:
-  struct Response { cv::Mat1d response; double maxResponse; cv::Point maxResponsePosition; };
-  struct TrainingData { std::shared_ptr< FC > xf; cv::Mat numeratorf, denominatorf; };
+  /** The size of a feature cell of the current scale in pixels, see ScaleAnalyser */
+  int m_cellSize;
+
+  struct Response { Mat1r response; double maxResponse; cv::Point maxResponsePosition; ResponseAnalysis analysis; std::shared_ptr< FC > zf; };
+  struct TrainingData { std::shared_ptr< FC > xf; KernelCache xfCache; cv::Mat numeratorf, denominatorf; };
+
+  /** Finds the peaks of every detection, see analyseResponse */
+  ResponseAnalyser m_responseAnalyser;
 
   const TrainingData getTrainingData( const cv::Mat & image, const std::shared_ptr< FC > & features ) const;
+  const TrainingData getTrainingData( const std::shared_ptr< FC > & xf ) const;
+  void updateModel( const TrainingData & trainingData );
   const DetectResult detectModel( const cv::Mat & image, const std::shared_ptr< FC > & features, const cv::Point_< double > & newPos ) const;
   const Response getResponse( const cv::Mat & image, const std::shared_ptr< FC > & features, const cv::Point_< double > & pos ) const;
+
+  /**
+   * Computes the responses of several equally sized feature sets, transforming all of them in one batch.
+   * Every response is analysed, see analyseResponse.
+   */
+  const std::vector< Response > getResponses( const std::vector< std::shared_ptr< FC > > & features ) const;
+
+  /** Runs the response analyser on the response and fills in its peaks and maximum */
+  void analyseResponse( Response & response ) const;
+
+  /**
+   * Converts the maximum of an analysed response into a detection.
+   *
+   * @param cellSize The size of a cell of the response in pixels.
+   */
+  const DetectResult resultFromResponse( const Response & response, const cv::Point_< double > & position, const double cellSize ) const;
   const cv::Mat detectResponse( const cv::Mat & image, const std::shared_ptr< FC > & features, const cv::Point_< double > & pos ) const;
+  const cv::Mat detectResponse( const std::shared_ptr< FC > & zf ) const;
 };
 
 #endif /* KCF_TRACKER_H_ */
@@ -167,17 +167,15 @@ public:
         tr_cost( a, b ) = 0;
       }
     }
-    for( std::size_t detectionIndex = 0; detectionIndex < unassignedDetections.size(); ++detectionIndex )
+    // Each suspended track scores all unassigned detections in one batch
+    for( auto itr = this->m_suspendedTrackers.begin(); itr != this->m_suspendedTrackers.end(); ++itr )
     {
-      for( auto itr = this->m_suspendedTrackers.begin(); itr != this->m_suspendedTrackers.end(); ++itr )
-      {
-        const auto trackerIndex = std::distance( this->m_suspendedTrackers.begin(), itr );
+      const auto trackerIndex = std::distance( this->m_suspendedTrackers.begin(), itr );
+      const std::vector< float > scores = itr->second.detect( rgb, depth, unassignedDetections );
 
-        tr_cost( detectionIndex, trackerIndex ) = std::floor(
-          100.0f * itr->second.detect(
-            rgb, depth, unassignedDetections[ detectionIndex ]
-          )
-        );
+      for( std::size_t detectionIndex = 0; detectionIndex < unassignedDetections.size(); ++detectionIndex )
+      {
+        tr_cost( detectionIndex, trackerIndex ) = std::floor( 100.0f * scores[ detectionIndex ] );
       }
     }
     std::vector< Assignment > tr_assignments = max_cost_assignment( tr_cost );
@@ -1,6 +1,8 @@
 #include <iostream>
 #include <memory>
 
+#include <tclap/CmdLine.h>
+
 #include "Camera.hpp"
 #include "SORTTR.hpp"
 #include "../cf_libs/dskcf/dskcf_tracker.hpp"
@@ -28,6 +30,12 @@ struct Tracker
     return this->m_tracker->detect( std::array< cv::Mat, 2 >{ rgb, depth }, r );
   }
 
+  std::vector< float > detect( const cv::Mat3b & rgb, const cv::Mat1w & depth, const std::vector< cv::Rect > & rects )
+  {
+    std::vector< cv::Rect_< double > > r( rects.begin(), rects.end() );
+    return this->m_tracker->detect( std::array< cv::Mat, 2 >{ rgb, depth }, r );
+  }
+
   std::shared_ptr< DskcfTracker > m_tracker;
 };
 
@@ -41,8 +49,71 @@ cv::Rect toBig( const cv::Rect input )
   return { input.x * 4, input.y * 4, input.width * 4, input.height * 4 };
 }
 
-int main()
+int main( int argc, const char** argv )
 {
+  TCLAP::CmdLine cmd( "SORT-TR", ' ' );
+  std::vector< std::string > kernels = { "gaussian", "linear", "polynomial" };
+  TCLAP::ValuesConstraint< std::string > kernelConstraint( kernels );
+  TCLAP::ValueArg< std::string > kernel( "", "kernel", "The kernel of the correlation filters", false, "gaussian", &kernelConstraint, cmd );
+  std::vector< std::string > featureNames = { "hog", "raw" };
+  TCLAP::ValuesConstraint< std::string > featureConstraint( featureNames );
+  TCLAP::ValueArg< std::string > features( "", "features", "The features of the colour and depth maps", false, "hog", &featureConstraint, cmd );
+  std::vector< std::string > channelNames = { "concatenate", "colour", "depth", "linear" };
+  TCLAP::ValuesConstraint< std::string > channelConstraint( channelNames );
+  TCLAP::ValueArg< std::string > channels( "", "channels",
+    "Track the features of both maps in one model, of one map only, or of both maps in two models", false, "concatenate", &channelConstraint, cmd );
+  TCLAP::ValueArg< int > projectedChannels( "", "projected_channels",
+    "Compress the features of every model to this many channels with an online PCA (0 keeps all channels)", false, 0, "int", cmd );
+  TCLAP::ValueArg< int > cellSize( "", "cell_size", "The size of a feature cell in pixels", false, 4, "int", cmd );
+  TCLAP::ValueArg< int > maxModelCells( "", "max_model_cells",
+    "Grow the feature cells of large targets until a model has at most this many cells (0 keeps the cell size)", false, 0, "int", cmd );
+  TCLAP::SwitchArg denseFeatures( "", "dense_features",
+    "Crop the HOG features of all tracks from shared maps of the whole frame; every cell size in use "
+    "costs a pass over the frame, so this only pays off with several tracks", cmd, false );
+  TCLAP::ValueArg< int > arenaThreads( "", "arena_threads",
+    "Run every tracker in its own TBB task arena with this many threads (0 uses the global pool)", false, 0, "int", cmd );
+  TCLAP::SwitchArg sequentialInnerLoops( "", "sequential_inner_loops",
+    "Run the per channel, per bin and per frame loops of the trackers sequentially", cmd, false );
+  TCLAP::ValueArg< int > openCvThreads( "", "opencv_threads",
+    "The number of threads OpenCV may use (-1 keeps OpenCV's default)", false, -1, "int", cmd );
+  cmd.parse( argc, argv );
+
+  try
+  {
+    if( cellSize.getValue() < 1 )
+    {
+      throw TCLAP::CmdLineParseException( "the cell size must be at least 1", cellSize.toString() );
+    }
+
+    if( maxModelCells.getValue() < 0 )
+    {
+      throw TCLAP::CmdLineParseException( "the cell budget must not be negative", maxModelCells.toString() );
+    }
+  }
+  catch( TCLAP::ArgException & argException )
+  {
+    std::cerr << "Command Line Argument Exception: " << argException.what() << std::endl;
+    return -1;
+  }
+
+  DskcfParameters paras;
+  paras.kernel = kernel.getValue();
+  paras.features = features.getValue();
+  paras.channels = channels.getValue();
+  paras.projectedChannels = projectedChannels.getValue();
+  paras.cellSize = cellSize.getValue();
+  paras.maxModelCells = maxModelCells.getValue();
+
+  if( denseFeatures.getValue() && paras.features == "hog" )
+  {
+    paras.denseFeatures = std::make_shared< DenseHOGFeatureExtractor >();
+  }
+
+  paras.execution.arenaConcurrency = arenaThreads.getValue();
+  paras.execution.sequentialInnerLoops = sequentialInnerLoops.getValue();
+  paras.execution.openCvThreads = openCvThreads.getValue();
+  paras.execution.applyOpenCvThreads();
+
   openni::OpenNI::initialize();
   nite::NiTE::initialize();
 
@@ -62,11 +133,11 @@ int main()
   };
 
   //Generic tracker factory
-  auto factory = []( const cv::Mat3b & rgb, const cv::Mat1w & depth, const cv::Rect & rect ) -> Tracker
+  auto factory = [paras]( const cv::Mat3b & rgb, const cv::Mat1w & depth, const cv::Rect & rect ) -> Tracker
   {
     Tracker result;
 
-    result.m_tracker = std::make_shared< DskcfTracker >();
+    result.m_tracker = std::make_shared< DskcfTracker >( paras );
     cv::Rect_< double > r = { rect.x, rect.y, rect.width, rect.height };
     result.m_tracker->reinit( std::array< cv::Mat, 2 >{ rgb, depth }, r );
 
@@ -91,6 +162,12 @@ int main()
     cv::resize( rgb, rgb_small, {160,120} );
     cv::resize( d, d_small, {160,120} );
 
+    // The small frames are resized in place, so the maps of the previous frame are dropped explicitly
+    if( paras.denseFeatures )
+    {
+      paras.denseFeatures->nextFrame();
+    }
+
     auto tracks = sorttr.update( rgb_small, d_small );
 
     for( auto detection : detections )
@@ -28,6 +28,12 @@ struct Tracker
     return this->m_tracker->detect( std::array< cv::Mat, 2 >{ rgb, depth }, r );
   }
 
+  std::vector< float > detect( const cv::Mat3b & rgb, const cv::Mat1w & depth, const std::vector< cv::Rect > & rects )
+  {
+    std::vector< cv::Rect_< double > > r( rects.begin(), rects.end() );
+    return this->m_tracker->detect( std::array< cv::Mat, 2 >{ rgb, depth }, r );
+  }
+
   std::shared_ptr< DskcfTracker > m_tracker;
 };
 
@@ -0,0 +1,153 @@
+/*
+// License Agreement (3-clause BSD License)
+// Copyright (c) 2016, Jake Hall, Massimo Camplan, Sion Hannuna.
+// Third party copyrights and patents are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the names of the copyright holders nor the names of the contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall copyright holders or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+*/
+
+/*
+Checks HOGFeatureExtractor::getFeaturesBatch against getFeatures for every
+window on its own. The batch shares the gradients of overlapping windows,
+which must not change the features: they are compared bit for bit, on colour
+frames and depth maps, for windows inside the frame, leaving it, entirely
+outside it and far apart from each other.
+*/
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#include "HOGFeatureExtractor.hpp"
+
+/**
+ * @returns True if both are null or hold equal features, bit for bit.
+ */
+static bool equalFeatures( const std::shared_ptr< FC > & left, const std::shared_ptr< FC > & right )
+{
+  if( !left || !right )
+  {
+    return !left && !right;
+  }
+
+  for( size_t c = 0; c < left->numberOfChannels(); ++c )
+  {
+    const cv::Mat & a = left->channels[ c ];
+    const cv::Mat & b = right->channels[ c ];
+
+    if( a.size() != b.size() || a.type() != b.type() )
+    {
+      return false;
+    }
+
+    for( int row = 0; row < a.rows; ++row )
+    {
+      if( !std::equal( a.ptr< Real >( row ), a.ptr< Real >( row ) + a.cols, b.ptr< Real >( row ) ) )
+      {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+/**
+ * @returns count windows of about size around center, at sub pixel positions.
+ */
+static std::vector< cv::Rect_< double > > windowsAround( cv::RNG & rng, const cv::Point2d & center, const cv::Size2d & size, int count )
+{
+  std::vector< cv::Rect_< double > > result;
+
+  for( int i = 0; i < count; ++i )
+  {
+    const cv::Size2d jittered( size.width + rng.uniform( -8.0, 8.0 ), size.height + rng.uniform( -8.0, 8.0 ) );
+    const cv::Point2d position( center.x + rng.uniform( -20.0, 20.0 ), center.y + rng.uniform( -20.0, 20.0 ) );
+
+    result.push_back( cv::Rect_< double >( position.x - jittered.width / 2, position.y - jittered.height / 2,
+      jittered.width, jittered.height ) );
+  }
+
+  return result;
+}
+
+int main()
+{
+  const HOGFeatureExtractor extractor;
+  const int cellSizes[] = { 4, 5, 8 };
+
+  cv::RNG rng( 1 );
+  cv::Mat3b colour( 240, 320 );
+  cv::Mat1w depth( 240, 320 );
+  rng.fill( colour, cv::RNG::UNIFORM, 0, 256 );
+  rng.fill( depth, cv::RNG::UNIFORM, 0, 8000 );
+
+  const std::vector< std::vector< cv::Rect_< double > > > batches = {
+    // overlapping windows inside the frame
+    windowsAround( rng, cv::Point2d( 160, 120 ), cv::Size2d( 64, 80 ), 6 ),
+    // overlapping windows leaving the frame at the top left and bottom right
+    windowsAround( rng, cv::Point2d( 10, 8 ), cv::Size2d( 60, 48 ), 5 ),
+    windowsAround( rng, cv::Point2d( 312, 236 ), cv::Size2d( 48, 60 ), 5 ),
+    // a window outside the frame and an empty one next to overlapping windows
+    {
+      cv::Rect_< double >( 100.5, 90.25, 64, 64 ), cv::Rect_< double >( 110.75, 95.5, 64, 60 ),
+      cv::Rect_< double >( -200, -200, 64, 64 ), cv::Rect_< double >( 120, 100, 0, 40 )
+    },
+    // windows far apart, which are extracted one by one
+    {
+      cv::Rect_< double >( 0, 0, 32, 32 ), cv::Rect_< double >( 280.5, 200.5, 32, 32 )
+    }
+  };
+
+  int failures = 0;
+
+  for( const cv::Mat & image : { cv::Mat( colour ), cv::Mat( depth ) } )
+  {
+    for( int cellSize : cellSizes )
+    {
+      for( size_t batch = 0; batch < batches.size(); ++batch )
+      {
+        const std::vector< std::shared_ptr< FC > > features = extractor.getFeaturesBatch( image, batches[ batch ], cellSize );
+
+        for( size_t window = 0; window < batches[ batch ].size(); ++window )
+        {
+          if( !equalFeatures( features[ window ], extractor.getFeatures( image, batches[ batch ][ window ], cellSize ) ) )
+          {
+            std::cerr << "getFeaturesBatch differs from getFeatures for window " << window << " of batch " << batch
+              << " with " << image.channels() << " channels and cell size " << cellSize << std::endl;
+            ++failures;
+          }
+        }
+      }
+    }
+  }
+
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,128 @@
+/*
+// License Agreement (3-clause BSD License)
+// Copyright (c) 2016, Jake Hall, Massimo Camplan, Sion Hannuna.
+// Third party copyrights and patents are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the names of the copyright holders nor the names of the contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall copyright holders or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+*/
+
+/*
+Checks cvFhog on uint16 depth maps against cvFhog on the same maps converted
+to float. Without missing depth both give the same features, bit for bit.
+Missing (zero) depth must not create edges: a flat map with holes has the
+features of the flat map.
+*/
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+
+#include <opencv2/core/core.hpp>
+
+#include "gradientMex.hpp"
+
+/**
+ * @returns True if both feature sets are equal, bit for bit.
+ */
+static bool equalFeatures( const std::shared_ptr< FC > & left, const std::shared_ptr< FC > & right )
+{
+  for( size_t c = 0; c < left->numberOfChannels(); ++c )
+  {
+    const cv::Mat & a = left->channels[ c ];
+    const cv::Mat & b = right->channels[ c ];
+
+    if( a.size() != b.size() || a.type() != b.type() )
+    {
+      return false;
+    }
+
+    for( int row = 0; row < a.rows; ++row )
+    {
+      if( !std::equal( a.ptr< Real >( row ), a.ptr< Real >( row ) + a.cols, b.ptr< Real >( row ) ) )
+      {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+int main()
+{
+  const int binSizes[] = { 4, 5, 8 };
+
+  cv::RNG rng( 1 );
+  int failures = 0;
+
+  for( int binSize : binSizes )
+  {
+    for( int iteration = 0; iteration < 10; ++iteration )
+    {
+      const cv::Size size( 40 + rng.uniform( 0, 60 ), 40 + rng.uniform( 0, 60 ) );
+
+      // Depth without holes, as uint16 and as float
+      cv::Mat1w depth( size );
+      cv::Mat depthFloat;
+      rng.fill( depth, cv::RNG::UNIFORM, 1, 60000 );
+      depth.convertTo( depthFloat, CV_32F );
+
+      std::shared_ptr< FC > fromDepth = std::make_shared< FC >();
+      std::shared_ptr< FC > fromFloat = std::make_shared< FC >();
+      piotr::cvFhog< Real, FC >( depth, fromDepth, binSize );
+      piotr::cvFhog< Real, FC >( depthFloat, fromFloat, binSize );
+
+      if( !equalFeatures( fromDepth, fromFloat ) )
+      {
+        std::cerr << "uint16 and float depth differ on a " << size << " map with bin size " << binSize << std::endl;
+        ++failures;
+      }
+
+      // A flat map with missing depth
+      cv::Mat1w flat( size, static_cast< ushort >( rng.uniform( 500, 8000 ) ) );
+      cv::Mat1w holes = flat.clone();
+
+      for( ushort & value : holes )
+      {
+        value = rng.uniform( 0, 10 ) == 0 ? 0 : value;
+      }
+
+      std::shared_ptr< FC > fromFlat = std::make_shared< FC >();
+      std::shared_ptr< FC > fromHoles = std::make_shared< FC >();
+      piotr::cvFhog< Real, FC >( flat, fromFlat, binSize );
+      piotr::cvFhog< Real, FC >( holes, fromHoles, binSize );
+
+      if( !equalFeatures( fromFlat, fromHoles ) )
+      {
+        std::cerr << "missing depth creates edges on a " << size << " map with bin size " << binSize << std::endl;
+        ++failures;
+      }
+    }
+  }
+
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,139 @@
+/*
+// License Agreement (3-clause BSD License)
+// Copyright (c) 2016, Jake Hall, Massimo Camplan, Sion Hannuna.
+// Third party copyrights and patents are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the names of the copyright holders nor the names of the contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall copyright holders or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+*/
+
+/*
+Checks cvFhog, which computes FHOG in row major order (fhogRowMajor), against
+the col major gradMag and fhog it replaced, on random grey and colour images
+at several bin sizes. The two only differ by float rounding.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#include "gradientMex.hpp"
+
+/**
+ * FHOG of image as the former cvFhog computed it, in col major order
+ * with the channels of a colour image reversed.
+ *
+ * @returns The 32 planes of binSize cells, each plane in col major order.
+ */
+static std::vector< float > referenceFhog( const cv::Mat & image, int binSize, bool calcEnergy )
+{
+  const int height = image.rows;
+  const int width = image.cols;
+  const int channels = image.channels();
+
+  std::vector< float > I( height * width * channels );
+  std::vector< float > M( height * width );
+  std::vector< float > O( height * width );
+  std::vector< float > H( ( height / binSize ) * ( width / binSize ) * 32 );
+
+  for( int row = 0; row < height; ++row )
+  {
+    const float * pixel = image.ptr< float >( row );
+
+    for( int col = 0; col < width; ++col )
+    {
+      for( int c = 0; c < channels; ++c )
+      {
+        I[ ( channels - 1 - c ) * width * height + col * height + row ] = pixel[ col * channels + c ];
+      }
+    }
+  }
+
+  piotr::gradMag( I.data(), M.data(), O.data(), height, width, channels, true );
+  piotr::fhog( M.data(), O.data(), H.data(), height, width, binSize, 9, -1, 0.2f, calcEnergy );
+
+  return H;
+}
+
+int main()
+{
+  const cv::Size sizes[] = { { 64, 64 }, { 45, 67 }, { 132, 100 }, { 16, 16 }, { 97, 33 } };
+  const int binSizes[] = { 4, 5, 8 };
+  const double tolerance = 1e-5;
+
+  cv::RNG rng( 1 );
+  int failures = 0;
+
+  for( const cv::Size & size : sizes )
+  {
+    for( int channels : { 1, 3 } )
+    {
+      cv::Mat image( size, CV_32FC( channels ) );
+      rng.fill( image, cv::RNG::UNIFORM, 0.0, 255.0 );
+
+      for( int binSize : binSizes )
+      {
+        for( int fhogChannels : { 31, 27 } )
+        {
+          std::shared_ptr< FC > features = std::make_shared< FC >();
+          piotr::cvFhog< Real, FC >( image, features, binSize, fhogChannels );
+
+          const std::vector< float > reference = referenceFhog( image, binSize, fhogChannels != 27 );
+          const int heightBin = size.height / binSize;
+          const int widthBin = size.width / binSize;
+          double worst = 0.0;
+
+          for( int c = 0; c < fhogChannels; ++c )
+          {
+            for( int row = 0; row < heightBin; ++row )
+            {
+              for( int col = 0; col < widthBin; ++col )
+              {
+                const double expected = reference[ c * heightBin * widthBin + col * heightBin + row ];
+                const double actual = features->channels[ c ].at< Real >( row, col );
+
+                worst = std::max( worst, std::abs( expected - actual ) / std::max( 1.0, std::abs( expected ) ) );
+              }
+            }
+          }
+
+          if( worst > tolerance )
+          {
+            std::cerr << "cvFhog differs from gradMag/fhog by " << worst << " on a " << size << " image with "
+              << channels << " channels, bin size " << binSize << " and " << fhogChannels << " channels" << std::endl;
+            ++failures;
+          }
+        }
+      }
+    }
+  }
+
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
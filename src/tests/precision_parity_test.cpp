@@ -0,0 +1,253 @@
+/*
+// License Agreement (3-clause BSD License)
+// Copyright (c) 2016, Jake Hall, Massimo Camplan, Sion Hannuna.
+// Third party copyrights and patents are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the names of the copyright holders nor the names of the contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall copyright holders or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+*/
+
+/*
+Checks the single precision build of the tracker model against the double
+precision build. The same source is built twice, with and without
+DSKCF_SINGLE_PRECISION; the double build runs the float build, which records
+its track of a fixed synthetic sequence, tracks the sequence itself and
+compares the detected positions, maximum responses and peak to sidelobe
+ratios frame by frame.
+
+Usage: precision_parity_test <single precision executable>
+       precision_parity_test --record <file>
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include "FFTEngine.hpp"
+#include "GaussianKernel.hpp"
+#include "HOGFeatureExtractor.hpp"
+#include "kcf_tracker.hpp"
+#include "math_helper.hpp"
+
+/** The largest difference of a detected position between the builds, in pixels */
+static const double POSITION_TOLERANCE = 0.05;
+
+/** The largest difference of a maximum response between the builds */
+static const double RESPONSE_TOLERANCE = 1e-3;
+
+/** The largest difference of a peak to sidelobe ratio between the builds, relative to the double build */
+static const double PSR_TOLERANCE = 1e-2;
+
+struct FrameResult
+{
+  double x;
+  double y;
+  double response;
+  double psr;
+};
+
+/**
+ * @returns A smooth random texture, which gives the HOG features some structure.
+ */
+static cv::Mat1b randomTexture( cv::RNG & rng, const cv::Size & size )
+{
+  cv::Mat1b texture( size );
+  rng.fill( texture, cv::RNG::UNIFORM, 0, 256 );
+  cv::GaussianBlur( texture, texture, cv::Size( 5, 5 ), 1.5 );
+
+  return texture;
+}
+
+/**
+ * @returns The top left corner of the target in the given frame, on whole pixels so that
+ *   both builds see the same frames.
+ */
+static cv::Point targetCorner( int frame )
+{
+  return cv::Point( 120 + cvRound( 40.0 * std::sin( 0.15 * frame ) ), 100 + cvRound( 25.0 * std::cos( 0.1 * frame ) ) );
+}
+
+/**
+ * @returns The features of the window around position, multiplied with the cosine window.
+ */
+static std::shared_ptr< FC > windowFeatures( const HOGFeatureExtractor & extractor, const cv::Mat & frame, const Point & position,
+  const Size & windowSize, int cellSize, const cv::Mat & cosineWindow )
+{
+  std::shared_ptr< FC > features = extractor.getFeatures( frame, boundingBoxFromPointSize( position, windowSize ), cellSize );
+  FC::mulFeatures( features, cosineWindow );
+
+  return features;
+}
+
+/**
+ * Tracks a textured target moving over a textured background with a Gaussian kernel KCF
+ * on HOG features, in the precision of this build.
+ *
+ * @returns The detection of every frame after the first.
+ */
+static std::vector< FrameResult > track()
+{
+  const int frames = 30;
+  const cv::Size targetSize( 40, 40 );
+
+  cv::RNG rng( 7 );
+  const cv::Mat1b background = randomTexture( rng, cv::Size( 320, 240 ) );
+  const cv::Mat1b target = randomTexture( rng, targetSize );
+
+  KcfParameters paras;
+  KcfTracker tracker( paras, std::make_shared< GaussianKernel >() );
+  HOGFeatureExtractor extractor;
+
+  const Size windowSize( targetSize.width * paras.padding, targetSize.height * paras.padding );
+  const cv::Size grid = sizeFloor( windowSize * ( 1.0 / paras.cellSize ) );
+  const Real sigma = static_cast< Real >( std::sqrt( static_cast< double >( targetSize.area() ) ) * paras.outputSigmaFactor / paras.cellSize );
+
+  Mat1r yf;
+  const cv::Mat labels = gaussianShapedLabelsShifted2D< Real >( sigma, cv::Size_< Real >( grid ) );
+  FFTEngine::getDefault()->dft( labels, yf );
+  const Mat1r cosineWindow = hanningWindow< Real >( grid.height ) * hanningWindow< Real >( grid.width ).t();
+  tracker.onScaleChange( Size( targetSize ), windowSize, paras.cellSize, yf, cosineWindow );
+
+  std::vector< FrameResult > result;
+  Point position;
+
+  for( int i = 0; i < frames; ++i )
+  {
+    cv::Mat1b grey = background.clone();
+    target.copyTo( grey( cv::Rect( targetCorner( i ), targetSize ) ) );
+
+    cv::Mat3b frame;
+    cv::cvtColor( grey, frame, cv::COLOR_GRAY2BGR );
+
+    if( i == 0 )
+    {
+      position = Point( targetCorner( i ) ) + Point( targetSize.width / 2.0, targetSize.height / 2.0 );
+      tracker.init( frame, windowFeatures( extractor, frame, position, windowSize, paras.cellSize, cosineWindow ), position );
+      continue;
+    }
+
+    const DetectResult detection = tracker.detect( frame,
+      windowFeatures( extractor, frame, position, windowSize, paras.cellSize, cosineWindow ), position );
+    position = detection.position;
+    result.push_back( { position.x, position.y, detection.maxResponse, detection.psr } );
+
+    tracker.update( frame, windowFeatures( extractor, frame, position, windowSize, paras.cellSize, cosineWindow ), position );
+  }
+
+  return result;
+}
+
+static bool record( const std::string & path )
+{
+  std::ofstream file( path );
+  file << ( sizeof( Real ) == sizeof( float ) ? "float" : "double" ) << std::endl;
+  file << std::setprecision( std::numeric_limits< double >::max_digits10 );
+
+  for( const FrameResult & frame : track() )
+  {
+    file << frame.x << " " << frame.y << " " << frame.response << " " << frame.psr << std::endl;
+  }
+
+  return static_cast< bool >( file );
+}
+
+static bool load( const std::string & path, std::vector< FrameResult > & result )
+{
+  std::ifstream file( path );
+  std::string precision;
+  FrameResult frame;
+
+  if( !( file >> precision ) || precision != "float" )
+  {
+    std::cerr << path << " was not recorded by a single precision build" << std::endl;
+    return false;
+  }
+
+  while( file >> frame.x >> frame.y >> frame.response >> frame.psr )
+  {
+    result.push_back( frame );
+  }
+
+  return true;
+}
+
+int main( int argc, const char ** argv )
+{
+  if( argc == 3 && std::string( argv[ 1 ] ) == "--record" )
+  {
+    return record( argv[ 2 ] ) ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+
+  if( argc != 2 || sizeof( Real ) != sizeof( double ) )
+  {
+    std::cerr << "Usage: " << argv[ 0 ] << " <single precision executable>, from a double precision build" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  const std::string path = "precision_parity_float.txt";
+  const std::string command = std::string( "\"" ) + argv[ 1 ] + "\" --record " + path;
+  std::vector< FrameResult > singles;
+
+  if( std::system( command.c_str() ) != 0 || !load( path, singles ) )
+  {
+    std::cerr << "Could not record the single precision track with " << command << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  const std::vector< FrameResult > doubles = track();
+  int failures = 0;
+
+  if( singles.size() != doubles.size() )
+  {
+    std::cerr << "The single precision track has " << singles.size() << " frames instead of " << doubles.size() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  for( size_t i = 0; i < doubles.size(); ++i )
+  {
+    const double position = std::hypot( singles[ i ].x - doubles[ i ].x, singles[ i ].y - doubles[ i ].y );
+    const double response = std::abs( singles[ i ].response - doubles[ i ].response );
+    const double psr = std::abs( singles[ i ].psr - doubles[ i ].psr ) / std::max( std::abs( doubles[ i ].psr ), 1.0 );
+
+    if( !( position <= POSITION_TOLERANCE && response <= RESPONSE_TOLERANCE && psr <= PSR_TOLERANCE ) )
+    {
+      std::cerr << "Frame " << i + 1 << ": the builds differ by " << position << " pixels, " << response
+        << " in the maximum response and " << psr << " in the relative peak to sidelobe ratio" << std::endl;
+      ++failures;
+    }
+  }
+
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}